@@ -17,11 +17,17 @@
 #include <string.h>
 #include <math.h>
 #include <assert.h>
+#include <pthread.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "stack.h"
 #include "queue.h"
 #include "set.h"
-#include "graph.h"
+#include "bitset.h"
+#include "bbaqui2_graph.h"
 #include "mymem.h"
 
 
@@ -63,15 +69,16 @@ int WordsOneLetterDiffer(char *word1, char *word2)
 {
 	int i = 0;
 	int count = 0;
+	int length = (int)strlen(word1);
 
-	if(strlen(word1) == strlen(word2))		// if the length of both the words are equal
+	if(length == (int)strlen(word2))		// if the length of both the words are equal
 	{
-		for(i = 0; i < strlen(word1); i++) 
+		for(i = 0; i < length; i++) 
 		{
 			if(word1[i] == word2[i])		// if the characters of both the words are same
 			count++;  						// increment count to 1;
 		}
-		if(count == strlen(word1) - 1)		// if the words differ by 1
+		if(count == length - 1)		// if the words differ by 1
 	  		return 1;
 		else 
 	  		return 0;
@@ -96,10 +103,544 @@ int Lookup(Graph *G, char *name)
 }
 
 
-void ProcessGraph(Graph *G)
+// #####################################################
+//
+// Packed words:
+//
+// Only words of the same length can differ by 1, so the words are
+// grouped into one bucket per length.  Each bucket stores its words as
+// fixed-width rows of Width bytes, zero-padded:  Width is the length
+// rounded up to 1, 2, 4, 8 or 16 bytes, or to a multiple of 16.  Then
+// a word is compared to 16 / Width candidates at once (Width <= 16),
+// or 16 bytes at a time (Width > 16), with SSE2 byte compares.
+//
+
+// _packWidth() function returns the row width for words of the given length
+static int _packWidth(int length)
+{
+	int width = 1;
+
+	if (length > 16)
+		return ((length + 15) / 16) * 16;
+
+	while (width < length)
+		width *= 2;
+
+	return width;
+}
+
+
+// PackWords() function groups the words of G into buckets by length, each stored as packed rows
+PackedWords *PackWords(Graph *G)
+{
+	int v = 0;
+	int b = 0;
+	int maxLength = 0;
+
+	PackedWords *P = (PackedWords *)mymalloc(sizeof(PackedWords));
+	int *length = (int *)mymalloc((G->NumVertices + 1) * sizeof(int));
+
+	P->BucketOf = (int *)mymalloc((G->NumVertices + 1) * sizeof(int));
+	P->RowOf = (int *)mymalloc((G->NumVertices + 1) * sizeof(int));
+
+	if (P == NULL || length == NULL || P->BucketOf == NULL || P->RowOf == NULL)
+	{
+		printf("\n**Error in PackWords: malloc failed to allocate\n\n");
+		exit(-1);
+	}
+
+	for (v = 0; v < G->NumVertices; v++)
+	{
+		length[v] = (int)strlen(G->Names[v]);
+
+		if (length[v] > maxLength)
+			maxLength = length[v];
+	}
+
+	// one bucket for each length that occurs, in order by length
+	int *bucketOfLength = (int *)mymalloc((maxLength + 1) * sizeof(int));
+
+	if (bucketOfLength == NULL)
+	{
+		printf("\n**Error in PackWords: malloc failed to allocate\n\n");
+		exit(-1);
+	}
+
+	for (b = 0; b <= maxLength; b++)
+		bucketOfLength[b] = 0;
+
+	for (v = 0; v < G->NumVertices; v++)
+		bucketOfLength[length[v]]++;		// count words of each length
+
+	P->NumBuckets = 0;
+
+	for (b = 0; b <= maxLength; b++)
+	{
+		if (bucketOfLength[b] > 0)
+			P->NumBuckets++;
+	}
+
+	P->Buckets = (WordBucket *)mymalloc((P->NumBuckets + 1) * sizeof(WordBucket));
+
+	if (P->Buckets == NULL)
+	{
+		printf("\n**Error in PackWords: malloc failed to allocate\n\n");
+		exit(-1);
+	}
+
+	int k = 0;
+
+	for (b = 0; b <= maxLength; b++)
+	{
+		if (bucketOfLength[b] == 0)
+		{
+			bucketOfLength[b] = -1;
+			continue;
+		}
+
+		WordBucket *B = &P->Buckets[k];
+
+		B->Length = b;
+		B->Width = _packWidth(b);
+		B->Count = 0;
+		B->Vertices = (Vertex *)mymalloc(bucketOfLength[b] * sizeof(Vertex));
+		B->Rows = (unsigned char *)mymalloc(bucketOfLength[b] * B->Width + 16);		// slack for last vector
+
+		if (B->Vertices == NULL || B->Rows == NULL)
+		{
+			printf("\n**Error in PackWords: malloc failed to allocate\n\n");
+			exit(-1);
+		}
+
+		memset(B->Rows, 0, bucketOfLength[b] * B->Width + 16);
+
+		bucketOfLength[b] = k;
+		k++;
+	}
+
+	// fill in the rows, in vertex order
+	for (v = 0; v < G->NumVertices; v++)
+	{
+		WordBucket *B = &P->Buckets[bucketOfLength[length[v]]];
+
+		P->BucketOf[v] = bucketOfLength[length[v]];
+		P->RowOf[v] = B->Count;
+
+		B->Vertices[B->Count] = v;
+		memcpy(B->Rows + B->Count * B->Width, G->Names[v], length[v]);
+		B->Count++;
+	}
+
+	myfree(bucketOfLength);
+	myfree(length);
+
+	return P;
+}
+
+
+// DeletePackedWords() function frees the memory associated with the packed words
+void DeletePackedWords(PackedWords *P)
+{
+	int b = 0;
+
+	for (b = 0; b < P->NumBuckets; b++)
+	{
+		myfree(P->Buckets[b].Vertices);
+		myfree(P->Buckets[b].Rows);
+	}
+
+	myfree(P->Buckets);
+	myfree(P->BucketOf);
+	myfree(P->RowOf);
+	myfree(P);
+}
+
+
+// _oneBit() function returns true if exactly one bit of x is set
+static int _oneBit(unsigned int x)
+{
+	return x != 0 && (x & (x - 1)) == 0;
+}
+
+
+// _oneBitLanes() function views the 16-bit mask differ as 16 / width lanes of width bits each, and returns a
+// mask with the top bit of every lane that has exactly one bit set (all done with bit tricks, no branching per lane)
+static unsigned int _oneBitLanes(unsigned int differ, int width)
+{
+	static const unsigned int lowBit[17] = { 0, 0xFFFF, 0x5555, 0, 0x1111, 0, 0, 0, 0x0101, 0, 0, 0, 0, 0, 0, 0, 0x0001 };
+	static const unsigned int highBit[17] = { 0, 0xFFFF, 0xAAAA, 0, 0x8888, 0, 0, 0, 0x8080, 0, 0, 0, 0, 0, 0, 0, 0x8000 };
+	unsigned int c = differ;
+
+	if (width == 1)
+		return differ;
+
+	// count the bits in each lane
+	c = c - ((c >> 1) & 0x5555);
+	if (width >= 4)
+		c = (c & 0x3333) + ((c >> 2) & 0x3333);
+	if (width >= 8)
+		c = (c + (c >> 4)) & 0x0F0F;
+	if (width >= 16)
+		c = (c + (c >> 8)) & 0x00FF;
+
+	// a lane of x is 0 if its count is 1; the top bit of each lane of nonzero is set if that lane of x is not 0
+	unsigned int x = c ^ lowBit[width];
+	unsigned int low = ~highBit[width] & 0xFFFF;
+	unsigned int nonzero = (((x & low) + low) | x) & highBit[width];
+
+	return ~nonzero & highBit[width];
+}
+
+
+// OneLetterMatches() function compares word (a packed row of bucket B) against rows first..first+count-1 of B,
+// stores the rows that differ from word in exactly 1 letter in matches[], and returns how many there are
+int OneLetterMatches(WordBucket *B, unsigned char *word, int first, int count, int *matches)
+{
+	int width = B->Width;
+	int last = first + count;
+	int found = 0;
+	int k = 0;
+	int m = 0;
+
+	if (last > B->Count)
+		last = B->Count;
+
+#ifdef __SSE2__
+	if (width <= 16)		// 16 / width candidates per compare
+	{
+		unsigned char pattern[16];
+		int batch = 16 / width;
+
+		for (m = 0; m < batch; m++)
+			memcpy(pattern + m * width, word, width);
+
+		__m128i q = _mm_loadu_si128((__m128i *)pattern);
+
+		for (k = first; k < last; k += batch)
+		{
+			__m128i c = _mm_loadu_si128((__m128i *)(B->Rows + k * width));
+			unsigned int differ = ~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(q, c)) & 0xFFFFu;
+
+			// padding bytes are 0 in both, so only letters can differ
+			unsigned int hits = _oneBitLanes(differ, width);
+
+			while (hits != 0)
+			{
+				m = __builtin_ctz(hits) / width;
+				hits &= hits - 1;		// clear lowest bit
+
+				if (k + m < last)
+				{
+					matches[found] = k + m;
+					found++;
+				}
+			}
+		}
+	}
+	else		// one candidate, 16 bytes at a time
+	{
+		for (k = first; k < last; k++)
+		{
+			unsigned char *row = B->Rows + k * width;
+			unsigned int differ = 0;
+			int letters = 0;
+			int i = 0;
+
+			for (i = 0; i < width && letters <= 1; i += 16)
+			{
+				__m128i q = _mm_loadu_si128((__m128i *)(word + i));
+				__m128i c = _mm_loadu_si128((__m128i *)(row + i));
+
+				differ = ~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(q, c)) & 0xFFFFu;
+
+				if (differ != 0)
+					letters += _oneBit(differ) ? 1 : 2;
+			}
+
+			if (letters == 1)
+			{
+				matches[found] = k;
+				found++;
+			}
+		}
+	}
+#else
+	for (k = first; k < last; k++)		// scalar fallback
+	{
+		unsigned char *row = B->Rows + k * width;
+		int letters = 0;
+		int i = 0;
+
+		for (i = 0; i < width && letters <= 1; i++)
+		{
+			if (word[i] != row[i])
+				letters++;
+		}
+
+		if (letters == 1)
+		{
+			matches[found] = k;
+			found++;
+		}
+	}
+#endif
+
+	return found;
+}
+
+
+// #####################################################
+//
+// Edge workers:
+//
+// Comparing word i against every other word only reads the graph, so
+// the rows i are split into one contiguous range per thread.  Each
+// worker buffers the edges of its range in the same order as the serial
+// loop; once all workers are done, the buffers are added to the graph
+// in worker order, so the graph is identical to the serial one.
+//
+// Workers never allocate (mymalloc is not thread-safe):  if a worker's
+// buffer fills up, it drops the row it was working on and stops; the
+// main thread then doubles the buffer and runs the worker again from
+// that row.
+//
+typedef struct EdgeWorker
+{
+	Graph       *G;
+	PackedWords *P;
+	Vertex  First;     // rows First..Last-1 belong to this worker
+	Vertex  Last;
+	Vertex  Row;       // next row to do, Last when done
+	int     Direct;    // serial build: add edges to graph right away
+	int     Launched;  // thread running in this round?
+	Vertex *Src;       // buffered edges Src[k] -> Dest[k]
+	Vertex *Dest;
+	int     NumEdges;
+	int     Capacity;
+} EdgeWorker;
+
+
+// _rowEdges() function finds the words that differ from word i by 1 and adds those edges to the graph, or
+// to the worker's buffer; returns 0 if the buffer filled up
+static int _rowEdges(EdgeWorker *W, Vertex i)
+{
+	WordBucket *B = &W->P->Buckets[W->P->BucketOf[i]];
+	unsigned char *word = B->Rows + W->P->RowOf[i] * B->Width;
+	int matches[256];
+	int k = 0;
+	int m = 0;
+
+	for (k = 0; k < B->Count; k += 256)		// a block of candidates at a time
+	{
+		int found = OneLetterMatches(B, word, k, 256, matches);
+
+		for (m = 0; m < found; m++)
+		{
+			Vertex j = B->Vertices[matches[m]];
+
+			if (W->Direct)
+			{
+				if (!AddEdge(W->G, i, j, 1))
+				{
+					printf("**Error: AddEdge failed?!\n\n"); 
+					exit(-1);
+				}
+			}
+			else if (W->NumEdges == W->Capacity)		// full
+				return 0;
+			else
+			{
+				W->Src[W->NumEdges] = i;
+				W->Dest[W->NumEdges] = j;
+				W->NumEdges++;
+			}
+		}
+	}
+
+	return 1;
+}
+
+
+// _runWorker() thread function finds the edges of rows Row..Last-1, stopping early if the buffer fills up
+static void *_runWorker(void *arg)
+{
+	EdgeWorker *W = (EdgeWorker *)arg;
+
+	for (; W->Row < W->Last; W->Row++)
+	{
+		int mark = W->NumEdges;
+
+		if (!_rowEdges(W, W->Row))		// full, drop partial row
+		{
+			W->NumEdges = mark;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+
+// _allocWorker() function sets the worker's edge buffer to the given capacity, keeping its edges
+static void _allocWorker(EdgeWorker *W, int capacity)
+{
+	Vertex *src = (Vertex *)mymalloc(capacity * sizeof(Vertex));
+	Vertex *dest = (Vertex *)mymalloc(capacity * sizeof(Vertex));
+
+	if (src == NULL || dest == NULL)
+	{
+		printf("\n**Error in AddOneLetterEdges: malloc failed to allocate\n\n");
+		exit(-1);
+	}
+
+	if (W->NumEdges > 0)
+	{
+		memcpy(src, W->Src, W->NumEdges * sizeof(Vertex));
+		memcpy(dest, W->Dest, W->NumEdges * sizeof(Vertex));
+	}
+
+	if (W->Src != NULL)
+	{
+		myfree(W->Src);
+		myfree(W->Dest);
+	}
+
+	W->Src = src;
+	W->Dest = dest;
+	W->Capacity = capacity;
+}
+
+
+// AddOneLetterEdges() function adds an edge between every pair of words that differ by 1, using numThreads threads
+void AddOneLetterEdges(Graph *G, int numThreads)
+{
+	int i = 0;
+	int t = 0;
+
+	PackedWords *P = PackWords(G);
+
+	if (numThreads > G->NumVertices)
+		numThreads = G->NumVertices;
+
+	if (numThreads <= 1)		// serial build, add edges directly
+	{
+		EdgeWorker W;
+
+		W.G = G;
+		W.P = P;
+		W.First = 0;
+		W.Last = G->NumVertices;
+		W.Row = 0;
+		W.Direct = 1;
+		W.Launched = 0;
+		W.Src = NULL;
+		W.Dest = NULL;
+		W.NumEdges = 0;
+		W.Capacity = 0;
+
+		_runWorker(&W);
+
+		DeletePackedWords(P);
+		return;
+	}
+
+	// one worker per thread, each with an equal share of the rows
+	EdgeWorker *workers = (EdgeWorker *)mymalloc(numThreads * sizeof(EdgeWorker));
+	pthread_t *threads = (pthread_t *)mymalloc(numThreads * sizeof(pthread_t));
+
+	if (workers == NULL || threads == NULL)
+	{
+		printf("\n**Error in AddOneLetterEdges: malloc failed to allocate\n\n");
+		exit(-1);
+	}
+
+	for (t = 0; t < numThreads; t++)
+	{
+		EdgeWorker *W = &workers[t];
+
+		W->G = G;
+		W->P = P;
+		W->Direct = 0;
+		W->First = (int)(((long long)G->NumVertices * t) / numThreads);
+		W->Last = (int)(((long long)G->NumVertices * (t + 1)) / numThreads);
+		W->Row = W->First;
+		W->Src = NULL;
+		W->Dest = NULL;
+		W->NumEdges = 0;
+		_allocWorker(W, 4 * (W->Last - W->First) + 16);		// a guess, grows as needed
+	}
+
+	// run the workers until every one has finished its rows; after the first round, unfinished workers ran out of buffer
+	int round = 0;
+	int unfinished = numThreads;
+
+	while (unfinished > 0)
+	{
+		for (t = 0; t < numThreads; t++)
+		{
+			EdgeWorker *W = &workers[t];
+
+			W->Launched = 0;
+
+			if (W->Row == W->Last)		// done
+				continue;
+
+			if (round > 0)
+				_allocWorker(W, 2 * W->Capacity);
+
+			if (pthread_create(&threads[t], NULL, _runWorker, W) != 0)
+			{
+				printf("\n**Error in AddOneLetterEdges: unable to create thread\n\n");
+				exit(-1);
+			}
+
+			W->Launched = 1;
+		}
+
+		unfinished = 0;
+
+		for (t = 0; t < numThreads; t++)
+		{
+			if (!workers[t].Launched)
+				continue;
+
+			pthread_join(threads[t], NULL);
+
+			if (workers[t].Row < workers[t].Last)
+				unfinished++;
+		}
+
+		round++;
+	}
+
+	// merge: add the buffered edges in worker order
+	for (t = 0; t < numThreads; t++)
+	{
+		EdgeWorker *W = &workers[t];
+
+		for (i = 0; i < W->NumEdges; i++)
+		{
+			if (!AddEdge(G, W->Src[i], W->Dest[i], 1))
+			{
+				printf("**Error: AddEdge failed?!\n\n"); 
+				exit(-1);
+			}
+		}
+
+		myfree(W->Src);
+		myfree(W->Dest);
+	}
+
+	myfree(threads);
+	myfree(workers);
+
+	DeletePackedWords(P);
+}
+
+
+void ProcessGraph(Graph *G, int numThreads)
 {
 	int i = 0;
-	int j = 0;
 	int isValid = 1;
 	int v = 0;
 	int distance = 0;
@@ -108,23 +649,10 @@ void ProcessGraph(Graph *G)
 	Vertex *vertex = NULL;
 	Vertex *bfs = NULL;
 
-	for (i = 0; i < G->NumVertices; i++)
-	{
-		for (j = 0; j < G->NumVertices; j++)
-		{
-	  		if (i != j)
-	  		{
-	    		if (WordsOneLetterDiffer(G->Names[i], G->Names[j]))
-	    		{
-	      			if (!AddEdge(G, i, j, 1))
-	      			{
-	        			printf("**Error: AddEdge failed?!\n\n"); 
-	        			exit(-1);
-	      			}
-	    		}
-	  		}
-		}
-	}
+	AddOneLetterEdges(G, numThreads);
+
+	// the graph is complete, convert to read-only CSR form:
+	FreezeGraph(G);
 
  	PrintGraph(G, "Word Ladder", 0);
 
@@ -247,6 +775,10 @@ Graph *CreateGraph(int N)
 	//
 	// graph is empty to start --- initialize remaining fields:
 	//
+	G->Offsets = NULL;
+	G->Dests = NULL;
+	G->Weights = NULL;
+	G->Frozen = 0;  /*false*/
 	G->NumVertices = 0;
 	G->NumEdges = 0;
 	G->Capacity = N;
@@ -263,13 +795,16 @@ Graph *CreateGraph(int N)
 //
 // Adds a vertex with the given name to G, returning a unique integer id
 // identifying this vertex.  Returns -1 if adding the vertex failed, i.e.
-// if the graph is full and additional vertices cannot be created; this
-// occurs when the graph's capacity is reached.
+// if the graph has been frozen.  The graph grows dynamically, doubling
+// in capacity whenever it becomes full.
 //
 int AddVertex(Graph *G, char *name)
 {
     int v = G->NumVertices;  // next free location:
 
+	if (G->Frozen)  // no more vertices once frozen:
+		return -1;
+
     int N = G->Capacity*2;
     if (G->NumVertices == G->Capacity)  // graph is full:
     {
@@ -329,7 +864,8 @@ int AddVertex(Graph *G, char *name)
 //
 // Adds a directed edge (src, dest, weight) to G.  If successful, true
 // (non-zero) is returned; if the edge could not be added (i.e. due to
-// invalid vertex ids), then false (0) is returned.
+// invalid vertex ids, or because the graph is frozen), then false (0)
+// is returned.
 //
 // NOTE: loops and multi-edges are allowed.  To allow easier handling of
 // multi-edges, edges are stored "in order by destination".  So when
@@ -341,6 +877,8 @@ int AddVertex(Graph *G, char *name)
 //
 int AddEdge(Graph *G, Vertex src, Vertex dest, int weight)
 {
+	if (G->Frozen)  // no more edges once frozen:
+		return 0;
 	if (src < 0 || src >= G->NumVertices)  // invalid vertex #:
 		return 0;
 	if (dest < 0 || dest >= G->NumVertices)  // invalid vertex #:
@@ -401,6 +939,68 @@ int AddEdge(Graph *G, Vertex src, Vertex dest, int weight)
 }
 
 
+//
+// FreezeGraph:
+//
+// Converts the graph's adjacency lists into compressed sparse row
+// (CSR) form:  one array of NumVertices+1 row offsets, and one
+// contiguous array each for edge destinations and weights.  The
+// edge lists are freed, and traversals from then on walk contiguous
+// memory.  The graph is read-only after this call; freezing an
+// already-frozen graph does nothing.
+//
+void FreezeGraph(Graph *G)
+{
+	int v;
+	int e;
+
+	if (G->Frozen)
+		return;
+
+	G->Offsets = (int *)mymalloc((G->NumVertices + 1) * sizeof(int));
+	G->Dests = (Vertex *)mymalloc((G->NumEdges + 1) * sizeof(Vertex));
+	G->Weights = (int *)mymalloc((G->NumEdges + 1) * sizeof(int));
+
+	if (G->Offsets == NULL || G->Dests == NULL || G->Weights == NULL)
+	{
+		printf("\n**Error in FreezeGraph: malloc failed to allocate\n\n");
+		exit(-1);
+	}
+
+	//
+	// copy each edge list into the next row, freeing the edges as
+	// we go; the lists are already in order by destination:
+	//
+	e = 0;
+
+	for (v = 0; v < G->NumVertices; ++v)
+	{
+		G->Offsets[v] = e;
+
+		Edge *cur = G->Vertices[v];
+		while (cur != NULL)
+		{
+			Edge *temp = cur;
+
+			G->Dests[e] = cur->dest;
+			G->Weights[e] = cur->weight;
+			++e;
+
+			cur = cur->next;
+			myfree(temp);
+		}
+	}
+
+	G->Offsets[G->NumVertices] = e;
+	assert(e == G->NumEdges);
+
+	myfree(G->Vertices);
+	G->Vertices = NULL;
+
+	G->Frozen = 1;  /*true*/
+}
+
+
 //
 // Neighbors:
 //
@@ -437,36 +1037,43 @@ Vertex *Neighbors(Graph *G, Vertex v)
 	}
 
 	//
-	// Now loop through the list of edges and copy the dest
-	// vertex of each edge:
+	// Now loop through the edges and copy the dest vertex of each
+	// edge.  The dest is our neighbor --- however, we have to be
+	// careful of multi-edges, i.e. edges with the same dest.
+	// Since edges are stored in order, edges with same dest
+	// appear next to each other --- so look to see if array
+	// already contains dest before we copy over:
 	//
-	Edge *cur = G->Vertices[v];
-
 	i = 0;
-	while (cur != NULL)  // for each edge out of v:
+
+	if (G->Frozen)  // walk v's row in CSR form:
 	{
-		//
-		// the dest is our neighbor --- however, we have to be
-		// careful of multi-edges, i.e. edges with the same dest.
-		// Since edges are stored in order, edges with same dest
-		// appear next to each other in the list --- so look to
-		// see if array already contains dest before we copy over:
-		//
-		if (i == 0)  // first neighbor, we always copy:
+		int e;
+
+		for (e = G->Offsets[v]; e < G->Offsets[v + 1]; ++e)
 		{
-			neighbors[i] = cur->dest;
-			++i;
+			if (i == 0 || neighbors[i - 1] != G->Dests[e])  // not a multi-edge:
+			{
+				neighbors[i] = G->Dests[e];
+				++i;
+			}
 		}
-		else if (neighbors[i - 1] != cur->dest)  // make sure not a multi-edge:
+	}
+	else  // walk v's edge list:
+	{
+		Edge *cur = G->Vertices[v];
+
+		while (cur != NULL)  // for each edge out of v:
 		{
-			neighbors[i] = cur->dest;
-			++i;
-		}
-		else // multi-edge, so ignore:
-			;
+			if (i == 0 || neighbors[i - 1] != cur->dest)  // not a multi-edge:
+			{
+				neighbors[i] = cur->dest;
+				++i;
+			}
 
-		cur = cur->next;
-  	}
+			cur = cur->next;
+	  	}
+	}
 
 	//
 	// follow last element with -1 and return:
@@ -503,14 +1110,29 @@ void PrintGraph(Graph *G, char *title, int complete)
 	{
 		printf("   %d (%s): ", v, G->Names[v]);
 
-		Edge *edge = G->Vertices[v];
-		while (edge != NULL)
+		if (G->Frozen)
+		{
+			int e;
+
+			for (e = G->Offsets[v]; e < G->Offsets[v + 1]; ++e)
+			{
+				printf("(%d,%d,%d)", v, G->Dests[e], G->Weights[e]);
+
+				if (e + 1 < G->Offsets[v + 1])
+					printf(", ");
+			}
+		}
+		else
 		{
-			printf("(%d,%d,%d)", edge->src, edge->dest, edge->weight);
+			Edge *edge = G->Vertices[v];
+			while (edge != NULL)
+			{
+				printf("(%d,%d,%d)", edge->src, edge->dest, edge->weight);
 
-			edge = edge->next;
-			if (edge != NULL)
-				printf(", ");
+				edge = edge->next;
+				if (edge != NULL)
+					printf(", ");
+			}
 		}
 
 		printf("\n");
@@ -643,11 +1265,11 @@ Vertex *BFS(Graph *G, Vertex v)
 	//
 	// Perform BFS, starting at given vertex v:
 	//
-	Queue *frontierQ = CreateQueue(N);
-	Set   *discoveredSet = CreateSet(N);
+	Queue  *frontierQ = CreateQueue(N);
+	Bitset *discoveredSet = CreateBitset(N);
 
 	if (!Enqueue(frontierQ, v)) { printf("Error!\n"); exit(-1); }
-	if (!AddToSet(discoveredSet, v)) { printf("Error!\n"); exit(-1); }
+	if (!AddToBitset(discoveredSet, v)) { printf("Error!\n"); exit(-1); }
 
 	i = 0;  // index into visited of where next vertex goes:
 
@@ -666,14 +1288,14 @@ Vertex *BFS(Graph *G, Vertex v)
 		{
 			Vertex adjV = neighbors[j];
 
-			if (!isElementInSet(discoveredSet, adjV))
+			if (!isElementInBitset(discoveredSet, adjV))
 			{
 				if (!Enqueue(frontierQ, adjV)) 
 				{ 
 					printf("Error!\n"); 
 					exit(-1); 
 				}
-				if (!AddToSet(discoveredSet, adjV)) 
+				if (!AddToBitset(discoveredSet, adjV)) 
 				{ 
 					printf("Error!\n"); 
 					exit(-1); 
@@ -692,7 +1314,7 @@ Vertex *BFS(Graph *G, Vertex v)
 	visited[i] = -1;  // mark end of vertices with -1:
 
 	DeleteQueue(frontierQ);
-	DeleteSet(discoveredSet);
+	DeleteBitset(discoveredSet);
 
 	return visited;
 }
@@ -741,15 +1363,15 @@ Vertex *BFSd(Graph *G, Vertex v, int distance)
 	}
 
 	// performs BFS, starting at given vertex v:
-	Queue *frontierQ = CreateQueue(N);
-	Set *discoveredSet = CreateSet(N);
+	Queue  *frontierQ = CreateQueue(N);
+	Bitset *discoveredSet = CreateBitset(N);
 
 	if(!Enqueue(frontierQ, v))
 	{
 		printf("Error!\n");
 		exit(-1);
 	}
-	if(!AddToSet(discoveredSet, v))
+	if(!AddToBitset(discoveredSet, v))
 	{
 		printf("Error!\n");
 		exit(-1);
@@ -775,14 +1397,14 @@ Vertex *BFSd(Graph *G, Vertex v, int distance)
 		{
 			Vertex adjV = neighbors[j];
 
-			if(!isElementInSet(discoveredSet, adjV))
+			if(!isElementInBitset(discoveredSet, adjV))
 			{
 				if(!Enqueue(frontierQ, adjV))
 				{
 					printf("Error!\n");
 					exit(-1);
 				}
-				if(!AddToSet(discoveredSet, adjV))
+				if(!AddToBitset(discoveredSet, adjV))
 				{
 				  printf("Error!\n");
 				  exit(-1);
@@ -811,7 +1433,7 @@ Vertex *BFSd(Graph *G, Vertex v, int distance)
     visited[i] = -1;		// mark end of vertices with -1:
     myfree(countDepth);
     DeleteQueue(frontierQ);
-    DeleteSet(discoveredSet);
+    DeleteBitset(discoveredSet);
 
     return visited;
 }
@@ -845,9 +1467,9 @@ Vertex *DFS(Graph *G, Vertex v)
 	//
 	int N = G->NumVertices + 1;
 
-	Stack *frontierStack = CreateStack(N);
-	Set   *visitedSet = CreateSet(N);
-	Queue *visitedQ = CreateQueue(N);
+	Stack  *frontierStack = CreateStack(N);
+	Bitset *visitedSet = CreateBitset(N);
+	Queue  *visitedQ = CreateQueue(N);
 
 	if (!Push(frontierStack, v)) { printf("Error!\n"); exit(-1); }
 
@@ -856,25 +1478,19 @@ Vertex *DFS(Graph *G, Vertex v)
 		Vertex currentV = Pop(frontierStack);
 
 		//
-		// visit:  add to visited list *if* not already there, since
-		// DFS may end up visiting vertices multiple times:
+		// visit:  add to visited list *if* not already visited, since
+		// DFS may pop the same vertex multiple times; then push
+		// neighbors in reverse order so that we visit in ascending
+		// order:
 		//
-		if (!isElementInQueue(visitedQ, currentV))
+		if (!isElementInBitset(visitedSet, currentV))
 		{
-			if (!Enqueue(visitedQ, currentV)) 
+			if (!AddToBitset(visitedSet, currentV)) 
 			{ 
 				printf("Error!\n"); 
 				exit(-1); 
 			}
-		}
-
-		//
-		// now push neighbors in reverse order so that we visit in
-		// ascending order:
-		//
-		if (!isElementInSet(visitedSet, currentV))
-		{
-			if (!AddToSet(visitedSet, currentV)) 
+			if (!Enqueue(visitedQ, currentV)) 
 			{ 
 				printf("Error!\n"); 
 				exit(-1); 
@@ -942,7 +1558,7 @@ Vertex *DFS(Graph *G, Vertex v)
 	// Done:
 	//
 	DeleteStack(frontierStack);
-	DeleteSet(visitedSet);
+	DeleteBitset(visitedSet);
 	DeleteQueue(visitedQ);
 
 	return visited;
@@ -963,17 +1579,28 @@ void DeleteGraph(Graph *G)
 
 	int j;
 
-	//free the Edge in each Vertices Linked List
-	for(j = 0; j < G->NumVertices; j++)
+	if (G->Frozen)
 	{
-		Edge *cur = G->Vertices[j];
-		while(cur != NULL)
+		//free the CSR arrays
+		myfree(G->Offsets);
+		myfree(G->Dests);
+		myfree(G->Weights);
+	}
+	else
+	{
+		//free the Edge in each Vertices Linked List
+		for(j = 0; j < G->NumVertices; j++)
 		{
-			myfree(cur);
-			cur = cur->next;
+			Edge *cur = G->Vertices[j];
+			while(cur != NULL)
+			{
+				Edge *temp = cur;
+				cur = cur->next;
+				myfree(temp);
+			}
 		}
+		myfree(G->Vertices);
 	}
-	myfree(G->Vertices);
 	myfree(G);
 }
 
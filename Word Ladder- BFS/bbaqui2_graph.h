@@ -13,18 +13,52 @@ typedef struct Edge
 	struct Edge *next;
 } Edge;
 
+//
+// A graph is built with AddVertex/AddEdge, which keep one linked list
+// of edges per vertex.  FreezeGraph then converts the lists into
+// compressed sparse row (CSR) form: the edges out of v are stored
+// contiguously in Dests[Offsets[v] .. Offsets[v+1]-1], in order by
+// destination, with matching Weights.  Once frozen, no more vertices
+// or edges may be added.
+//
 typedef struct Graph
 {
-	Edge **Vertices;
-	char **Names;
-	int    NumVertices;
-	int    NumEdges;
-	int    Capacity;
+	Edge  **Vertices;  // adjacency lists (build phase only)
+	char  **Names;
+	int    *Offsets;   // CSR row offsets, NumVertices+1 (frozen only)
+	Vertex *Dests;     // CSR edge destinations, NumEdges (frozen only)
+	int    *Weights;   // CSR edge weights, NumEdges (frozen only)
+	int     Frozen;
+	int     NumVertices;
+	int     NumEdges;
+	int     Capacity;
 } Graph;
 
+//
+// Words grouped by length for the all-pairs edge build, each bucket
+// stored as fixed-width, zero-padded rows (see PackWords):
+//
+typedef struct WordBucket
+{
+	int     Length;    // # of letters in each word
+	int     Width;     // bytes per row
+	int     Count;     // # of words
+	Vertex *Vertices;  // Vertices[k] is the word in row k, ascending
+	unsigned char *Rows;
+} WordBucket;
+
+typedef struct PackedWords
+{
+	WordBucket *Buckets;   // in order by length
+	int     NumBuckets;
+	int    *BucketOf;  // BucketOf[v], RowOf[v]:  where word v is stored
+	int    *RowOf;
+} PackedWords;
+
 Graph  *CreateGraph(int N);
 int     AddVertex(Graph *G, char *name);
 int     AddEdge(Graph *G, Vertex src, Vertex dest, int weight);
+void    FreezeGraph(Graph *G);
 Vertex *Neighbors(Graph *G, Vertex v);
 void    PrintGraph(Graph *G, char *title, int complete);
 Vertex *BFS(Graph *G, Vertex v);
@@ -33,5 +67,9 @@ void DeleteGraph(Graph *G);
 void InputFile(Graph *G, char *filename);
 int WordsOneLetterDiffer(char *word1, char *word2);
 int Lookup(Graph *G, char *name);
-void ProcessGraph(Graph *G);
+PackedWords *PackWords(Graph *G);
+void DeletePackedWords(PackedWords *P);
+int OneLetterMatches(WordBucket *B, unsigned char *word, int first, int count, int *matches);
+void AddOneLetterEdges(Graph *G, int numThreads);
+void ProcessGraph(Graph *G, int numThreads);
 Vertex *BFSd(Graph *G, Vertex v, int distance);
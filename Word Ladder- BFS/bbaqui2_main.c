@@ -20,14 +20,19 @@
 #include <math.h>
 #include <assert.h>
 
-#include "graph.h"
+#include "bbaqui2_graph.h"
 #include "mymem.h"
 
 
 
-int main()
+// usage: a.out [--threads=N], to build the graph's edges using N threads (default 1)
+int main(int argc, char *argv[])
 {
 	Graph *G;
+	int numThreads = 1;
+
+	if (argc > 1 && strncmp(argv[1], "--threads=", 10) == 0 && atoi(argv[1] + 10) > 0)
+		numThreads = atoi(argv[1] + 10);
 
 	printf("** Starting Word Ladder App **\n\n");
 
@@ -35,7 +40,7 @@ int main()
 
 	InputFile(G, "merriam-webster-len4.txt");
 
-	ProcessGraph(G);
+	ProcessGraph(G, numThreads);
 
 	//
 	// done:
@@ -0,0 +1,116 @@
+/*bitset.c*/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "bitset.h"
+#include "mymem.h"
+
+
+// #####################################################
+//
+// Bitset:
+//
+
+#define BITS_PER_WORD  ((int)(8 * sizeof(BitsetWordType)))
+
+//
+// CreateBitset:
+//
+// Creates an empty bitset for elements in the range 0..N-1.
+//
+Bitset *CreateBitset(int N)
+{
+  Bitset *B;
+
+  if (N < 1)
+  {
+    printf("\n**Error in CreateBitset invalid parameter N (%d)\n\n", N);
+    return NULL;
+  }
+
+  //
+  // allocate bitset header:
+  //
+  B = (Bitset *)mymalloc(sizeof(Bitset));
+  if (B == NULL)
+  {
+    printf("\n**Error in CreateBitset: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  //
+  // allocate array of bits, rounding up to whole words:
+  //
+  B->NumWords = (N + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  B->Capacity = N;
+
+  B->Words = (BitsetWordType *)mymalloc(B->NumWords * sizeof(BitsetWordType));
+  if (B->Words == NULL)
+  {
+    printf("\n**Error in CreateBitset: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  ClearBitset(B);
+
+  //
+  // done:
+  //
+  return B;
+}
+
+//
+// DeleteBitset:
+//
+// Frees the memory associated with this bitset.
+//
+void DeleteBitset(Bitset *B)
+{
+  myfree(B->Words);
+  myfree(B);
+}
+
+//
+// ClearBitset:
+//
+// Removes all elements from the bitset.
+//
+void ClearBitset(Bitset *B)
+{
+  memset(B->Words, 0, B->NumWords * sizeof(BitsetWordType));
+}
+
+//
+// AddToBitset:
+//
+// Adds the given element to the bitset, returning true (non-zero)
+// if successful, false (0) if e is out of range.
+//
+int AddToBitset(Bitset *B, int e)
+{
+  if (e < 0 || e >= B->Capacity)  // invalid element:
+    return 0;  /*false*/
+
+  B->Words[e / BITS_PER_WORD] |= ((BitsetWordType)1) << (e % BITS_PER_WORD);
+
+  return 1;  /*true*/
+}
+
+//
+// isElementInBitset:
+//
+// Return true (non-zero) if e is a member of B, false (0) if not.
+//
+int isElementInBitset(Bitset *B, int e)
+{
+  if (e < 0 || e >= B->Capacity)  // invalid element:
+    return 0;  /*false*/
+
+  return (B->Words[e / BITS_PER_WORD] >> (e % BITS_PER_WORD)) & 1;
+}
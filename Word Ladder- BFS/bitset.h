@@ -0,0 +1,21 @@
+/*bitset.h*/
+
+//
+// Bitset:
+//
+// Dense set of integers 0..N-1, one bit per element.  Adding and
+// testing an element are O(1); the capacity is fixed at creation.
+//
+typedef unsigned int BitsetWordType;
+typedef struct Bitset
+{
+  BitsetWordType  *Words;  // array of bits, 32 elements per word:
+  int  NumWords;     // # of words in array
+  int  Capacity;     // elements must be in range 0..Capacity-1
+} Bitset;
+
+Bitset *CreateBitset(int N);
+void    DeleteBitset(Bitset *B);
+void    ClearBitset(Bitset *B);
+int     AddToBitset(Bitset *B, int e);
+int     isElementInBitset(Bitset *B, int e);
@@ -142,13 +142,14 @@ AVLNode *LeftRotate(AVLNode *N)
 // the tree as necessary.  Returns a pointer to the root of
 // the new tree; if the value to insert is already in the
 // tree, nothing happens and a pointer to the root of the
-// original tree is returned.
+// original tree is returned.  The new node comes from pool, or
+// from mymalloc if pool is NULL.
 // 
 //
 #define TRUE  1
 #define FALSE 0
 
-AVLNode *Insert(AVLNode *root, AVLElementType value)
+AVLNode *Insert(AVLNode *root, AVLElementType value, MemPool *pool)
 {
   AVLNode *prev = NULL;
   AVLNode *cur = root;
@@ -180,7 +181,10 @@ AVLNode *Insert(AVLNode *root, AVLElementType value)
   //
   AVLNode *newNode;
 
-  newNode = (AVLNode *)mymalloc(sizeof(AVLNode));
+  if (pool != NULL)
+    newNode = (AVLNode *)mypool_alloc(pool);
+  else
+    newNode = (AVLNode *)mymalloc(sizeof(AVLNode));
   newNode->value = value;
   newNode->height = 0;
   newNode->left = NULL;
@@ -355,16 +359,21 @@ void PrintInorder(AVLNode *root)
 //
 // FreeAVLTree
 //
-// Frees the memory associated with this AVL tree.
+// Frees the memory associated with this AVL tree; pool must be
+// the one its nodes were inserted with (NULL => mymalloc).
 //
-void FreeAVLTree(AVLNode *root)
+void FreeAVLTree(AVLNode *root, MemPool *pool)
 {
   if (root == NULL)
     ;
   else
   {
-    FreeAVLTree(root->left);
-    FreeAVLTree(root->right);
-    myfree(root);
+    FreeAVLTree(root->left, pool);
+    FreeAVLTree(root->right, pool);
+
+    if (pool != NULL)
+      mypool_free(pool, root);
+    else
+      myfree(root);
   }
 }
@@ -24,12 +24,22 @@ typedef struct AVLNode
   struct AVLNode  *right;
 } AVLNode;
 
+//
+// Each tree chooses where its nodes come from:  pass pool NULL to
+// Insert and FreeAVLTree to allocate nodes one at a time with
+// mymalloc, or a pool (see mymem.h, created with
+// mypool_create(sizeof(AVLNode), ...)) to take them from the pool,
+// so the tree can also be released all at once with mypool_delete.
+// Every call on a given tree must pass the same pool.
+//
+struct MemPool;
+
 AVLNode *CreateAVLTree();
 AVLNode *Contains(AVLNode *root, AVLElementType value);
-AVLNode *Insert(AVLNode *root, AVLElementType value);
+AVLNode *Insert(AVLNode *root, AVLElementType value, struct MemPool *pool);
 
 int Count(AVLNode *root);
 int Height(AVLNode *root);
 
 void PrintInorder(AVLNode *root);
-void FreeAVLTree(AVLNode *root);
+void FreeAVLTree(AVLNode *root, struct MemPool *pool);
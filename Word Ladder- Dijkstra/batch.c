@@ -0,0 +1,481 @@
+/*batch.c*/
+
+//
+// Batch queries:  reads "src dest" pairs, answers them on a pool of
+// worker threads, and writes one answer per line in input order.
+//
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "nameindex.h"
+#include "workspace.h"
+#include "graph.h"
+#include "batch.h"
+#include "mymem.h"
+#include "timer.h"
+
+
+//
+// FindLadder:
+//
+// Finds a shortest ladder from v1 to v2 with the given search
+// (SEARCH_...), returning it in the form of Dijkstra().  If stats
+// is not NULL, it's filled in with the search's counters.
+//
+Vertex *FindLadder(Graph *G, Vertex v1, Vertex v2, int search, SearchStats *stats, SearchWorkspace *W)
+{
+  Vertex *ladder;
+
+  timer_begin("find ladder");
+
+  if (search == SEARCH_BIDIR)
+    ladder = BidirectionalBFS(G, v1, v2, stats, W);
+  else if (search == SEARCH_ASTAR)
+    ladder = AStar(G, v1, v2, stats, W);
+  else
+    ladder = Dijkstra(G, v1, v2, stats, W);
+
+  timer_end();
+
+  return ladder;
+}
+
+
+// #####################################################
+//
+// Chunks:
+//
+// Queries are read, answered and written a chunk at a time, so
+// memory stays bounded however long the input is.  The words of a
+// chunk's queries are kept back to back in one text buffer.
+//
+#define BATCH_CHUNK  65536  // max # of queries per chunk
+
+typedef struct BatchQuery
+{
+  int     SrcAt;   // words, as offsets into chunk's Text:
+  int     DestAt;  // -1 => line had only one word
+  Vertex  Src;     // -1 => word not in graph
+  Vertex  Dest;
+  Vertex *Ladder;  // answer, or NULL if not searched
+  SearchStats Stats;  // the search's counters, if kept
+} BatchQuery;
+
+typedef struct BatchChunk
+{
+  BatchQuery *Queries;
+  int         NumQueries;
+  char       *Text;
+  int         TextSize;
+  int         TextCapacity;
+} BatchChunk;
+
+//
+// _addText:
+//
+// Appends word (and its '\0') to the chunk's text, returning its
+// offset; the text grows by doubling.
+//
+static int _addText(BatchChunk *C, char *word)
+{
+  int  n = (int)strlen(word) + 1;
+  int  at = C->TextSize;
+
+  if (C->TextSize + n > C->TextCapacity)
+  {
+    int   capacity = 2 * C->TextCapacity + n;
+    char *text = (char *)mymalloc(capacity * sizeof(char));
+    if (text == NULL)
+    {
+      printf("\n**Error in RunBatch: malloc failed to allocate\n\n");
+      exit(-1);
+    }
+
+    if (C->Text != NULL)
+    {
+      memcpy(text, C->Text, C->TextSize);
+      myfree(C->Text);
+    }
+
+    C->Text = text;
+    C->TextCapacity = capacity;
+  }
+
+  memcpy(C->Text + at, word, n);
+  C->TextSize += n;
+
+  return at;
+}
+
+//
+// _readChunk:
+//
+// Reads the next chunk of queries from input, looking up the words
+// in G; blank lines are skipped.  Returns the # of queries read, 0
+// at end of input.
+//
+static int _readChunk(FILE *input, Graph *G, BatchChunk *C)
+{
+  char  line[256];
+  int   linesize = sizeof(line) / sizeof(line[0]);
+  char  src[256], dest[256];
+
+  C->NumQueries = 0;
+  C->TextSize = 0;
+
+  timer_begin("read queries");
+
+  while (C->NumQueries < BATCH_CHUNK && fgets(line, linesize, input) != NULL)
+  {
+    if (strchr(line, '\n') == NULL && !feof(input))  // too long, discard the rest:
+    {
+      int c;
+
+      while ((c = fgetc(input)) != EOF && c != '\n')
+        ;
+    }
+
+    int n = sscanf(line, "%255s %255s", src, dest);
+
+    if (n < 1)  // blank:
+      continue;
+
+    BatchQuery *Q = &C->Queries[C->NumQueries];
+
+    Q->SrcAt = _addText(C, src);
+    Q->Src = Name2Vertex(G, src);
+    Q->DestAt = -1;
+    Q->Dest = -1;
+    Q->Ladder = NULL;
+
+    if (n == 2)
+    {
+      Q->DestAt = _addText(C, dest);
+      Q->Dest = Name2Vertex(G, dest);
+    }
+
+    C->NumQueries++;
+  }
+
+  timer_end();
+
+  return C->NumQueries;
+}
+
+//
+// _writeChunk:
+//
+// Writes the answers to the chunk's queries to stdout, in order,
+// and frees the ladders:
+//
+//   src dest <length> <src> ... <dest>   the ladder
+//   src dest none                        no ladder
+//   src dest unknown                     a word is not in the graph
+//   src invalid                          the line has only one word
+//
+// If withStats, each searched query's line ends with a tab and its
+// search counters, as name=value pairs (see SearchStats).
+//
+static void _writeChunk(Graph *G, BatchChunk *C, int withStats)
+{
+  int  q, i;
+
+  timer_begin("write answers");
+
+  for (q = 0; q < C->NumQueries; ++q)
+  {
+    BatchQuery *Q = &C->Queries[q];
+
+    fputs(C->Text + Q->SrcAt, stdout);
+
+    if (Q->DestAt < 0)
+    {
+      fputs(" invalid\n", stdout);
+      continue;
+    }
+
+    putchar(' ');
+    fputs(C->Text + Q->DestAt, stdout);
+
+    if (Q->Ladder == NULL)  // not searched:
+      fputs(" unknown", stdout);
+    else if (Q->Ladder[0] == -1)
+      fputs(" none", stdout);
+    else
+    {
+      for (i = 0; Q->Ladder[i] != -1; ++i)  // length is # of edges:
+        ;
+      printf(" %d", i - 1);
+
+      for (i = 0; Q->Ladder[i] != -1; ++i)
+      {
+        putchar(' ');
+        fputs(Vertex2Name(G, Q->Ladder[i]), stdout);
+      }
+    }
+
+    if (withStats && Q->Ladder != NULL)
+      printf("\tdequeued=%d expanded=%d scanned=%ld relaxed=%ld frontier=%d allocs=%ld ns=%lld",
+             Q->Stats.VerticesDequeued, Q->Stats.VerticesExpanded, Q->Stats.EdgesScanned,
+             Q->Stats.Relaxations, Q->Stats.PeakFrontier, Q->Stats.Allocations,
+             Q->Stats.Nanos);
+
+    putchar('\n');
+
+    if (Q->Ladder != NULL)
+      myfree(Q->Ladder);
+  }
+
+  timer_end();
+}
+
+
+// #####################################################
+//
+// Batch workers:
+//
+// Each worker owns a range of the chunk's queries, [Next, End), and
+// answers them front to back with its own search workspace; the graph
+// is only read.  A worker that runs out steals the back half of
+// another worker's remaining range, so a few slow queries (e.g. long
+// "no ladder" searches) don't leave the other threads idle.  Each
+// range is guarded by its worker's lock.  The answers go into the
+// queries themselves, so the output order doesn't depend on who
+// answered what.
+//
+typedef struct BatchWorker
+{
+  pthread_mutex_t      Lock;  // guards Next and End
+  int                  Next;  // next query to answer
+  int                  End;   // end of this worker's range
+  int                  Index;
+  int                  NumWorkers;
+  struct BatchWorker  *Workers;  // all of them, for stealing
+  Graph               *G;
+  int                  Search;
+  int                  WithStats;  // keep each query's SearchStats?
+  BatchChunk          *C;
+  SearchWorkspace     *W;
+} BatchWorker;
+
+//
+// _takeQuery:
+//
+// Removes the next query from the front of the worker's own range;
+// returns -1 if the range is empty.
+//
+static int _takeQuery(BatchWorker *B)
+{
+  int  q = -1;
+
+  pthread_mutex_lock(&B->Lock);
+
+  if (B->Next < B->End)
+  {
+    q = B->Next;
+    B->Next++;
+  }
+
+  pthread_mutex_unlock(&B->Lock);
+
+  return q;
+}
+
+//
+// _steal:
+//
+// Takes the back half (rounded up) of the first non-empty range
+// among the other workers, starting after B, and makes it B's own
+// range.  Returns true (non-zero) if work was stolen, false (0) if
+// every range is empty.
+//
+static int _steal(BatchWorker *B)
+{
+  int  k;
+
+  for (k = 1; k < B->NumWorkers; ++k)
+  {
+    BatchWorker *victim = &B->Workers[(B->Index + k) % B->NumWorkers];
+    int          first = 0, end = 0;
+
+    pthread_mutex_lock(&victim->Lock);
+
+    if (victim->Next < victim->End)
+    {
+      int take = (victim->End - victim->Next + 1) / 2;
+
+      end = victim->End;
+      first = end - take;
+      victim->End = first;
+    }
+
+    pthread_mutex_unlock(&victim->Lock);
+
+    if (first < end)
+    {
+      pthread_mutex_lock(&B->Lock);
+      B->Next = first;
+      B->End = end;
+      pthread_mutex_unlock(&B->Lock);
+
+      return 1;  /*true*/
+    }
+  }
+
+  return 0;  /*false*/
+}
+
+//
+// _runWorker:
+//
+// Answers queries until there are none left to take or steal.
+//
+static void *_runWorker(void *arg)
+{
+  BatchWorker *B = (BatchWorker *)arg;
+
+  while (1)
+  {
+    int q = _takeQuery(B);
+
+    if (q < 0)
+    {
+      if (!_steal(B))  // all done:
+        break;
+
+      continue;
+    }
+
+    BatchQuery *Q = &B->C->Queries[q];
+
+    if (Q->Src >= 0 && Q->Dest >= 0)
+      Q->Ladder = FindLadder(B->G, Q->Src, Q->Dest, B->Search,
+                             B->WithStats ? &Q->Stats : NULL, B->W);
+  }
+
+  return NULL;
+}
+
+
+//
+// RunBatch:
+//
+// Answers a batch of queries without prompting:  reads lines of the
+// form "src dest" from the given file (or stdin if NULL), and writes
+// one line per query to stdout, in input order (see _writeChunk).
+// Blank lines are skipped.  The queries are answered by numThreads
+// workers, each with its own search workspace; G is shared, and must
+// not change meanwhile.  If withStats, each answer is followed by
+// its search's counters (see _writeChunk).
+//
+// Output is fully buffered, so stdout should not have been written
+// to yet.
+//
+void RunBatch(Graph *G, int search, char *filename, int numThreads, int withStats)
+{
+  FILE       *input = stdin;
+  BatchChunk  C;
+  int         t;
+
+  if (numThreads < 1)
+    numThreads = 1;
+
+  if (filename != NULL)
+  {
+    input = fopen(filename, "r");
+    if (input == NULL)
+    {
+      printf("**ERROR: '%s' not found\n\n", filename);
+      exit(-1);
+    }
+  }
+
+  setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+
+  C.Queries = (BatchQuery *)mymalloc(BATCH_CHUNK * sizeof(BatchQuery));
+  C.Text = NULL;
+  C.TextSize = 0;
+  C.TextCapacity = 0;
+
+  BatchWorker *workers = (BatchWorker *)mymalloc(numThreads * sizeof(BatchWorker));
+  pthread_t   *threads = (pthread_t *)mymalloc(numThreads * sizeof(pthread_t));
+  if (C.Queries == NULL || workers == NULL || threads == NULL)
+  {
+    printf("\n**Error in RunBatch: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  for (t = 0; t < numThreads; ++t)
+  {
+    BatchWorker *B = &workers[t];
+
+    pthread_mutex_init(&B->Lock, NULL);
+    B->Index = t;
+    B->NumWorkers = numThreads;
+    B->Workers = workers;
+    B->G = G;
+    B->Search = search;
+    B->WithStats = withStats;
+    B->C = &C;
+    B->W = CreateSearchWorkspace(G->NumVertices);
+  }
+
+  //
+  // a chunk at a time:  split the queries into equal ranges, let the
+  // workers loose, then write the answers in order:
+  //
+  while (_readChunk(input, G, &C) > 0)
+  {
+    for (t = 0; t < numThreads; ++t)
+    {
+      workers[t].Next = (int)(((long long)C.NumQueries * t) / numThreads);
+      workers[t].End = (int)(((long long)C.NumQueries * (t + 1)) / numThreads);
+    }
+
+    if (numThreads == 1)  // no need for a thread:
+      _runWorker(&workers[0]);
+    else
+    {
+      for (t = 0; t < numThreads; ++t)
+      {
+        if (pthread_create(&threads[t], NULL, _runWorker, &workers[t]) != 0)
+        {
+          printf("\n**Error in RunBatch: unable to create thread\n\n");
+          exit(-1);
+        }
+      }
+
+      for (t = 0; t < numThreads; ++t)
+        pthread_join(threads[t], NULL);
+    }
+
+    _writeChunk(G, &C, withStats);
+  }
+
+  fflush(stdout);
+
+  //
+  // done:
+  //
+  for (t = 0; t < numThreads; ++t)
+  {
+    pthread_mutex_destroy(&workers[t].Lock);
+    DeleteSearchWorkspace(workers[t].W);
+  }
+
+  myfree(workers);
+  myfree(threads);
+  myfree(C.Queries);
+  if (C.Text != NULL)
+    myfree(C.Text);
+
+  if (filename != NULL)
+    fclose(input);
+}
@@ -0,0 +1,13 @@
+/*batch.h*/
+
+//
+// Batch queries:  answers many "src dest" ladder queries without
+// prompting, on a pool of threads, writing the answers in input
+// order (see RunBatch).
+//
+#define SEARCH_DIJKSTRA  0
+#define SEARCH_BIDIR     1
+#define SEARCH_ASTAR     2
+
+Vertex *FindLadder(Graph *G, Vertex v1, Vertex v2, int search, SearchStats *stats, SearchWorkspace *W);
+void    RunBatch(Graph *G, int search, char *filename, int numThreads, int withStats);
@@ -0,0 +1,410 @@
+/*bench.c*/
+
+//
+// Benchmark for the word ladder graph:  for each dictionary, builds
+// the graph, then runs seeded random query workloads through
+// Dijkstra(), BFS() and BFSd():
+//
+//   near         src and dest 1..3 steps apart
+//   far          dest is the last vertex reached by a BFS from src,
+//                i.e. as far away as it gets in src's component, and
+//                more than 3 steps away
+//   unreachable  src and dest in different components
+//
+// Each pair is searched with Dijkstra(src, dest); with BFS(src), the
+// whole of src's component; and with BFSd(src, d), where d is the
+// ladder's length (BENCH_UNREACHABLE_DEPTH if there is none).  The
+// same seed always gives the same pairs.
+//
+// Output is one JSON object per line on stdout:  a "build" line per
+// dictionary (build time, graph size, peak bytes allocated), then a
+// "query" line per workload and search (latency percentiles in
+// microseconds, mean # of vertices expanded, peak bytes allocated
+// during the workload).  The phase times go to stderr.
+//
+// Usage:  ./bench [--seed=N] [--queries=N] [--perf] [dictionary ...]
+//
+// with the three bundled dictionaries by default.  With --perf, the
+// phase summary also has each phase's hardware counters (cycles,
+// instructions, cache and branch misses; see timer.h).
+//
+// Build:  make bench
+//
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "nameindex.h"
+#include "workspace.h"
+#include "graph.h"
+#include "wordgraph.h"
+#include "mymem.h"
+#include "timer.h"
+
+#define BENCH_SEED               251
+#define BENCH_QUERIES            1000
+#define BENCH_NEAR_DISTANCE      3  // near pairs are 1..3 steps apart
+#define BENCH_UNREACHABLE_DEPTH  4  // BFSd depth when there's no ladder
+#define BENCH_MAX_TRIES          100  // x queries, when picking pairs
+
+#define BENCH_NEAR         0
+#define BENCH_FAR          1
+#define BENCH_UNREACHABLE  2
+
+static char *WorkloadNames[] = { "near", "far", "unreachable" };
+
+typedef struct BenchPair
+{
+  Vertex  Src;
+  Vertex  Dest;
+  int     Length;  // ladder length from Dijkstra(), -1 => none
+} BenchPair;
+
+
+//
+// _random:
+//
+// xorshift64* generator, so the workloads don't depend on the C
+// library's rand(); returns a number in 0..n-1.
+//
+static int _random(unsigned long long *state, int n)
+{
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+
+  return (int)(((*state * 2685821657736338717ULL) >> 33) % (unsigned long long)n);
+}
+
+//
+// _pickPairs:
+//
+// Fills pairs[] with up to numQueries random pairs of the given
+// workload, and returns the # found; a workload may have fewer (or
+// no) pairs, e.g. a graph with one component has no unreachable
+// pairs.
+//
+static int _pickPairs(Graph *G, int workload, int numQueries, unsigned long long *state,
+                      SearchWorkspace *W, BenchPair *pairs)
+{
+  int  N = G->NumVertices;
+  int  n = 0;
+  int  tries;
+
+  for (tries = 0; n < numQueries && tries < BENCH_MAX_TRIES * numQueries; ++tries)
+  {
+    Vertex  src = _random(state, N);
+    Vertex  dest = -1;
+    Vertex *V;
+    int     i, k, count;
+
+    if (workload == BENCH_NEAR)
+    {
+      //
+      // any vertex after the first marker (step 0) is 1..d steps away:
+      //
+      V = BFSd(G, src, BENCH_NEAR_DISTANCE, NULL, W);
+
+      for (i = 0, count = 0; count < BENCH_NEAR_DISTANCE + 1; ++i)
+        count += (V[i] == -1);
+
+      int  at = 2;  // skip src and its marker
+      int  candidates = i - at - BENCH_NEAR_DISTANCE;  // less the other markers
+
+      if (candidates > 0)
+      {
+        int  pick = _random(state, candidates);
+
+        for (i = at; ; ++i)
+        {
+          if (V[i] != -1 && pick-- == 0)
+            break;
+        }
+
+        dest = V[i];
+      }
+
+      myfree(V);
+    }
+    else if (workload == BENCH_FAR)
+    {
+      //
+      // if BFS reaches more vertices than are within the near
+      // distance, the last one reached is beyond it:
+      //
+      V = BFS(G, src, NULL, W);
+
+      for (i = 0; V[i] != -1; ++i)
+        ;
+
+      Vertex last = V[i - 1];
+      myfree(V);
+
+      V = BFSd(G, src, BENCH_NEAR_DISTANCE, NULL, W);
+
+      int  near = 0;
+      for (k = 0, count = 0; count < BENCH_NEAR_DISTANCE + 1; ++k)
+      {
+        if (V[k] == -1)
+          count++;
+        else
+          near++;
+      }
+
+      if (i > near)
+        dest = last;
+
+      myfree(V);
+    }
+    else  // unreachable:
+    {
+      Vertex other = _random(state, N);
+
+      if (!SameComponent(G, src, other))
+        dest = other;
+    }
+
+    if (dest >= 0)
+    {
+      pairs[n].Src = src;
+      pairs[n].Dest = dest;
+      pairs[n].Length = -1;
+      n++;
+    }
+  }
+
+  return n;
+}
+
+static int _compareDoubles(const void *a, const void *b)
+{
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+//
+// _percentile:
+//
+// Nearest-rank percentile p (0..100) of the n sorted values.
+//
+static double _percentile(double *sorted, int n, int p)
+{
+  int  rank = (int)(((long long)p * n + 99) / 100);  // ceil(p% of n):
+
+  if (rank < 1)
+    rank = 1;
+
+  return sorted[rank - 1];
+}
+
+//
+// _runSearch:
+//
+// Runs every pair through one search, timing each call, and prints
+// the "query" line.
+//
+static void _runSearch(Graph *G, char *dictionary, int workload, char *search,
+                       BenchPair *pairs, int n, unsigned long long seed,
+                       SearchWorkspace *W, double *latencies)
+{
+  long long  expanded = 0;
+  double     total = 0.0;
+  int        q, i;
+
+  mymem_reset_peak();
+
+  for (q = 0; q < n; ++q)
+  {
+    BenchPair *P = &pairs[q];
+    Vertex    *V;
+
+    if (strcmp(search, "dijkstra") == 0)
+    {
+      SearchStats stats;
+
+      timer_start();
+      V = Dijkstra(G, P->Src, P->Dest, &stats, W);
+      timer_stop();
+
+      for (i = 0; V[i] != -1; ++i)  // length is # of edges:
+        ;
+      P->Length = i - 1;
+
+      expanded += stats.VerticesExpanded;
+    }
+    else if (strcmp(search, "bfs") == 0)
+    {
+      timer_start();
+      V = BFS(G, P->Src, NULL, W);
+      timer_stop();
+
+      for (i = 0; V[i] != -1; ++i)
+        ;
+      expanded += i;
+    }
+    else  // bfsd:
+    {
+      int  d = (P->Length < 0) ? BENCH_UNREACHABLE_DEPTH : P->Length;
+      int  markers = 0;
+
+      timer_start();
+      V = BFSd(G, P->Src, d, NULL, W);
+      timer_stop();
+
+      for (i = 0; markers < d + 1; ++i)
+      {
+        if (V[i] == -1)
+          markers++;
+        else
+          expanded++;
+      }
+    }
+
+    myfree(V);
+
+    latencies[q] = timer_value() * 1e6;  // in microseconds:
+    total += latencies[q];
+  }
+
+  qsort(latencies, n, sizeof(double), _compareDoubles);
+
+  printf("{\"bench\":\"query\",\"dict\":\"%s\",\"workload\":\"%s\",\"search\":\"%s\","
+         "\"seed\":%llu,\"queries\":%d,",
+         dictionary, WorkloadNames[workload], search, seed, n);
+
+  if (n > 0)
+    printf("\"p50_us\":%.3f,\"p95_us\":%.3f,\"p99_us\":%.3f,\"mean_us\":%.3f,"
+           "\"mean_expanded\":%.1f,",
+           _percentile(latencies, n, 50), _percentile(latencies, n, 95),
+           _percentile(latencies, n, 99), total / n, (double)expanded / n);
+
+  printf("\"peak_bytes\":%ld}\n", mymem_peak_bytes() - mymem_live_bytes());
+}
+
+//
+// _benchDictionary:
+//
+// Builds the graph for one dictionary, and runs the workloads.
+//
+static void _benchDictionary(char *dictionary, unsigned long long seed, int numQueries)
+{
+  int  workload;
+
+  //
+  // build, as the app does with its defaults:
+  //
+  long before = mymem_live_bytes();
+
+  mymem_reset_peak();
+
+  timer_start();
+  timer_begin("build graph");
+
+  Graph *G = Read_and_AddWords(dictionary);
+  AddEdges(G, EDGES_BY_BUCKETS, 1);
+  FreezeGraph(G);
+
+  timer_end();
+  timer_stop();
+
+  printf("{\"bench\":\"build\",\"dict\":\"%s\",\"vertices\":%d,\"edges\":%d,"
+         "\"components\":%d,\"build_s\":%.6f,\"graph_bytes\":%ld,\"peak_bytes\":%ld}\n",
+         dictionary, G->NumVertices, G->NumEdges, G->NumComponents, timer_value(),
+         mymem_live_bytes() - before, mymem_peak_bytes() - before);
+
+  //
+  // the workloads:
+  //
+  SearchWorkspace *W = CreateSearchWorkspace(G->NumVertices);
+  BenchPair       *pairs = (BenchPair *)mymalloc((numQueries + 1) * sizeof(BenchPair));
+  double          *latencies = (double *)mymalloc((numQueries + 1) * sizeof(double));
+  if (pairs == NULL || latencies == NULL)
+  {
+    printf("\n**Error in bench: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  for (workload = BENCH_NEAR; workload <= BENCH_UNREACHABLE; ++workload)
+  {
+    unsigned long long state = (seed + 1) * 0x9E3779B97F4A7C15ULL + workload;
+
+    timer_begin(WorkloadNames[workload]);
+
+    int n = _pickPairs(G, workload, numQueries, &state, W, pairs);
+
+    timer_begin("dijkstra");  // first, it finds the lengths for BFSd:
+    _runSearch(G, dictionary, workload, "dijkstra", pairs, n, seed, W, latencies);
+    timer_end();
+
+    timer_begin("bfs");
+    _runSearch(G, dictionary, workload, "bfs", pairs, n, seed, W, latencies);
+    timer_end();
+
+    timer_begin("bfsd");
+    _runSearch(G, dictionary, workload, "bfsd", pairs, n, seed, W, latencies);
+    timer_end();
+
+    timer_end();
+  }
+
+  fflush(stdout);
+
+  myfree(latencies);
+  myfree(pairs);
+  DeleteSearchWorkspace(W);
+  DeleteGraph(G);
+}
+
+
+int main(int argc, char *argv[])
+{
+  char  *defaults[] = { "merriam-webster-len4.txt", "merriam-webster-len5.txt", "merriam-webster.txt" };
+  char **dictionaries = defaults;
+  int    numDictionaries = sizeof(defaults) / sizeof(defaults[0]);
+  unsigned long long seed = BENCH_SEED;
+  int    numQueries = BENCH_QUERIES;
+  int    arg, d;
+
+  //
+  // options, then dictionaries:
+  //
+  for (arg = 1; arg < argc && strncmp(argv[arg], "--", 2) == 0; ++arg)
+  {
+    if (strncmp(argv[arg], "--seed=", 7) == 0)
+      seed = strtoull(argv[arg] + 7, NULL, 10);
+    else if (strncmp(argv[arg], "--queries=", 10) == 0 && atoi(argv[arg] + 10) > 0)
+      numQueries = atoi(argv[arg] + 10);
+    else if (strcmp(argv[arg], "--perf") == 0)
+      timer_enable_counters();
+    else
+    {
+      printf("**Error: unknown option '%s'\n", argv[arg]);
+      printf("usage: %s [--seed=N] [--queries=N] [--perf] [dictionary ...]\n", argv[0]);
+      return -1;
+    }
+  }
+
+  if (arg < argc)
+  {
+    dictionaries = &argv[arg];
+    numDictionaries = argc - arg;
+  }
+
+  for (d = 0; d < numDictionaries; ++d)
+  {
+    timer_begin(dictionaries[d]);
+    _benchDictionary(dictionaries[d], seed, numQueries);
+    timer_end();
+  }
+
+  timer_summary(stderr);
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+/*client.c*/
+
+//
+// Query client for the word ladder server (see server.h):  sends
+// each line of stdin to the server as a request, and prints each
+// response line to stdout.  Requests are sent as they are read, so
+// the client works both interactively and with a file of requests
+// piped in; it exits once the server has answered everything sent.
+//
+// Usage:  ./client ADDRESS
+//
+// where ADDRESS is a port # on 127.0.0.1, or the path of a Unix
+// domain socket, as given to the server's --serve option.
+//
+// Build:  make client
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+//
+// _connectTo:
+//
+// Connects to the server at the given address; returns the socket,
+// or -1 (after printing an error) on failure.
+//
+static int _connectTo(char *address)
+{
+  int  fd;
+
+  if (address[0] != '\0' && strspn(address, "0123456789") == strlen(address))
+  {
+    struct sockaddr_in  sin;
+
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons((unsigned short)atoi(address));
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&sin, sizeof(sin)) == 0)
+      return fd;
+  }
+  else
+  {
+    struct sockaddr_un  sun;
+
+    if (strlen(address) >= sizeof(sun.sun_path))
+    {
+      printf("**ERROR: socket path '%s' is too long\n", address);
+      return -1;
+    }
+
+    memset(&sun, 0, sizeof(sun));
+    sun.sun_family = AF_UNIX;
+    strcpy(sun.sun_path, address);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&sun, sizeof(sun)) == 0)
+      return fd;
+  }
+
+  printf("**ERROR: unable to connect to '%s': %s\n", address, strerror(errno));
+  if (fd >= 0)
+    close(fd);
+
+  return -1;
+}
+
+//
+// _sendAll:
+//
+// Writes all n bytes to fd; returns false (0) if the connection fails.
+//
+static int _sendAll(int fd, char *data, size_t n)
+{
+  while (n > 0)
+  {
+    ssize_t sent = write(fd, data, n);
+
+    if (sent < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      return 0;  /*false*/
+    }
+
+    data += sent;
+    n -= (size_t)sent;
+  }
+
+  return 1;  /*true*/
+}
+
+
+int main(int argc, char *argv[])
+{
+  char  data[4096];
+  int   inputDone = 0;  /*false*/
+
+  if (argc != 2)
+  {
+    printf("usage: %s ADDRESS\n", argv[0]);
+    return -1;
+  }
+
+  signal(SIGPIPE, SIG_IGN);  // a closed connection is reported by write
+
+  int fd = _connectTo(argv[1]);
+  if (fd < 0)
+    return -1;
+
+  //
+  // forward stdin to the server and the server to stdout until the
+  // server closes the connection; once stdin ends, shut down our
+  // side, which tells the server no more requests are coming:
+  //
+  while (1)
+  {
+    struct pollfd  fds[2];
+    int            nfds = 0;
+
+    fds[nfds].fd = fd;
+    fds[nfds].events = POLLIN;
+    nfds++;
+
+    if (!inputDone)
+    {
+      fds[nfds].fd = STDIN_FILENO;
+      fds[nfds].events = POLLIN;
+      nfds++;
+    }
+
+    if (poll(fds, nfds, -1) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      printf("**ERROR: poll failed: %s\n", strerror(errno));
+      return -1;
+    }
+
+    if (fds[0].revents != 0)  // from the server:
+    {
+      ssize_t n = read(fd, data, sizeof(data));
+
+      if (n <= 0)  // server is done:
+        break;
+
+      fwrite(data, 1, (size_t)n, stdout);
+      fflush(stdout);
+    }
+
+    if (!inputDone && fds[1].revents != 0)  // from stdin:
+    {
+      ssize_t n = read(STDIN_FILENO, data, sizeof(data));
+
+      if (n <= 0)
+      {
+        inputDone = 1;  /*true*/
+        shutdown(fd, SHUT_WR);
+      }
+      else if (!_sendAll(fd, data, (size_t)n))
+      {
+        printf("**ERROR: connection lost\n");
+        return -1;
+      }
+    }
+  }
+
+  close(fd);
+
+  return 0;
+}
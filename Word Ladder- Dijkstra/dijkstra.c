@@ -1,3 +1,26 @@
+/*dijkstra.c*/
+
+//
+// Weighted shortest paths over the word graph.
+//
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <limits.h>
+
+#include "nameindex.h"
+#include "stack.h"
+#include "pqueue.h"
+#include "workspace.h"
+#include "graph.h"
+#include "mymem.h"
+
+
 //
 // getEdgeWeight:
 //
@@ -21,35 +44,55 @@ int getEdgeWeight(Graph *G, Vertex src, Vertex dest)
     printf("\n**Error in getEdgeWeight: dest vertex (%d) invalid.\n\n", dest);
     exit(-1);
   }
-
   //
-  // search src's edge list, note that multi-edges appear together:
+  // search src's edges, note that multi-edges appear together:
   //
-  Edge *cur = G->Vertices[src];
   int   weight;
   int   haveEdge = 0;  /*false*/
-
-  while (cur != NULL)
+  if (G->Frozen)  // binary search src's row for the first edge to dest:
   {
-    if (dest == cur->dest)  // candidate edge:
+    int low = G->Offsets[src];
+    int high = G->Offsets[src + 1];
+    while (low < high)
     {
-      if (!haveEdge) // first edge:
+      int mid = low + ((high - low) / 2);
+      if (G->Dests[mid] < dest)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    for (; low < G->Offsets[src + 1] && G->Dests[low] == dest; ++low)
+    {
+      if (!haveEdge || G->Weights[low] < weight)
       {
         haveEdge = 1;  /*true*/
-        weight = cur->weight;
+        weight = G->Weights[low];
       }
-      else if (cur->weight < weight)  // multi-edge:
+    }
+  }
+  else
+  {
+    Edge *cur = G->Vertices[src];
+    while (cur != NULL)
+    {
+      if (dest == cur->dest)  // candidate edge:
       {
-        weight = cur->weight;  // smaller, so update:
+        if (!haveEdge) // first edge:
+        {
+          haveEdge = 1;  /*true*/
+          weight = cur->weight;
+        }
+        else if (cur->weight < weight)  // multi-edge:
+        {
+          weight = cur->weight;  // smaller, so update:
+        }
       }
+      else if (dest < cur->dest)  // out of order, end search:
+        break;
+      // next edge:
+      cur = cur->next;
     }
-    else if (dest < cur->dest)  // out of order, end search:
-      break;
-
-    // next edge:
-    cur = cur->next;
   }
-
   // 
   // did we find an edge?  make sure...
   //
@@ -58,7 +101,6 @@ int getEdgeWeight(Graph *G, Vertex src, Vertex dest)
     printf("\n**Error in getEdgeWeight: no edge found from %d to %d.\n\n", src, dest);
     exit(-1);
   }
-
   //
   // success:
   //
@@ -67,223 +109,336 @@ int getEdgeWeight(Graph *G, Vertex src, Vertex dest)
 
 
 //
-// Performs Dijkstra's shortest path algorithm to find the shortest path
-// from src to dest.  Returns a dynamically-allocated array of vertices
-// denoting this path; the array will start with src, contain 0 or more
-// vertices that lead to dest, followed by dest, and ending with -1.  
-// If there is no pat from src to dest, the array will contain only -1.
-//
-// NOTE: returns NULL if src or dest are not valid vertex ids.
+// _pathTo:
 //
-// NOTE: it is the responsibility of the CALLER to free the 
-// returned array when they are done.
+// Follows the predecessors back from dest to src, and returns the
+// path as a dynamically-allocated array:  src, 0 or more vertices,
+// dest, and -1; or just -1 if there is no path.  A vertex the search
+// never touched has no predecessor.
 //
-int PopMin(Queue *unvisitedQ, int distance[])
+static Vertex *_pathTo(SearchWorkspace *W, Vertex src, Vertex dest)
 {
-  int    N = unvisitedQ->NumElements;
-  Stack *S = CreateStack(N); 
+  Vertex *predecessor = W->Predecessor;
+  Vertex *path;
+  int     length = 0;  // # of edges:
+  int     i;
+  Vertex  v;
 
-  assert(!isEmptyQueue(unvisitedQ));
+  for (v = dest; W->Stamp[v] == W->Epoch && predecessor[v] != -1; v = predecessor[v])
+    ++length;
 
-  //
-  // search for smallest vertex distance in the queue,
-  // saving other elements in a stack so we can put back
-  // later:
-  //
-  int minV = Dequeue(unvisitedQ);  // assume first vertex is the min:
-
-  while (!isEmptyQueue(unvisitedQ))  // look for smaller vertex:
+  if (length == 0)  // no path:
   {
-    int v = Dequeue(unvisitedQ);
+    path = (Vertex *)mymalloc(1 * sizeof(Vertex));
+    if (path == NULL)
+    {
+      printf("\n**Error in _pathTo: malloc failed to allocate\n\n");
+      exit(-1);
+    }
 
-    if (distance[v] < distance[minV])
+    path[0] = -1;  // no path from src to dest:
+  }
+  else
+  {
+    path = (Vertex *)mymalloc((length + 2) * sizeof(Vertex));  // length + 1 vertices + -1
+    if (path == NULL)
     {
-      Push(S, minV);  // save so we can put back in queue:
-      minV = v;  // our new min:
+      printf("\n**Error in _pathTo: malloc failed to allocate\n\n");
+      exit(-1);
     }
-    else  // not smaller, so save to enqueue later:
+
+    // the path is stored backwards in predecessor, so fill backwards:
+    v = dest;
+    for (i = length; i >= 0; --i)
     {
-      Push(S, v);
+      path[i] = v;
+      v = predecessor[v];
     }
-  }
 
-  //
-  // empty the stack back into the queue:
-  //
-  while (!isEmptyStack(S))
-  {
-    Enqueue(unvisitedQ, Pop(S));
+    assert(path[0] == src);
+    path[length + 1] = -1;  // need -1 terminator at the end:
   }
 
-  // NOTE: at this point queue is now one smaller, with
-  // min element removed.  Let's confirm:
-  assert(unvisitedQ->NumElements == (N - 1));
-
-  //
-  // done:
-  // 
-  DeleteStack(S);
-
-  return minV;
+  return path;
 }
 
 
-Vertex *Dijkstra(Graph *G, Vertex src, Vertex dest)
+//
+// Dijkstra:
+//
+// Performs Dijkstra's shortest path algorithm to find the shortest path
+// from src to dest.  Returns a dynamically-allocated array of vertices
+// denoting this path; the array will start with src, contain 0 or more
+// vertices that lead to dest, followed by dest, and ending with -1.  
+// If there is no path from src to dest, the array will contain only -1.
+//
+// The unvisited vertices are kept in a binary-heap priority queue,
+// keyed by distance; only vertices reached so far are in the queue.
+// The search stops as soon as dest is settled, and does not start if
+// src and dest are in different components (see FreezeGraph).
+//
+// If stats is not NULL, the search's counters are stored there (see
+// SearchStats).  W is the search workspace (see workspace.h); pass
+// NULL to use a temporary one.
+//
+// NOTE: the graph must be frozen (see FreezeGraph).
+//
+// NOTE: returns NULL if src or dest are not valid vertex ids.
+//
+// NOTE: it is the responsibility of the CALLER to free the 
+// returned array when they are done.
+//
+Vertex *Dijkstra(Graph *G, Vertex src, Vertex dest, SearchStats *stats, SearchWorkspace *W)
 {
-  int  INF = INT_MAX;
-
   if (src < 0 || src >= G->NumVertices)  // invalid vertex #:
     return NULL;
   if (dest < 0 || dest >= G->NumVertices)  // invalid vertex #:
     return NULL;
 
+  if (stats != NULL)
+    BeginSearchStats(stats);
+
   //
-  // allocate distances array:
+  // distances and predecessors live in the workspace; a vertex not
+  // yet touched by this search is at distance Infinity:
   //
-  int N = G->NumVertices;
-
-  int *distance = (int *)malloc(N * sizeof(int));
-  if (distance == NULL)
-  {
-    printf("\n**Error in Dijkstra: malloc failed to allocate\n\n");
-    exit(-1);
-  }
-
-  Vertex *predecessor = (Vertex *)malloc(N * sizeof(Vertex));
-  if (predecessor == NULL)
-  {
-    printf("\n**Error in Dijkstra: malloc failed to allocate\n\n");
-    exit(-1);
-  }
+  SearchWorkspace *WS = StartSearch(W, G->NumVertices);
+  unsigned int     epoch = WS->Epoch;
+  unsigned int    *stamp = WS->Stamp;
+  int             *distance = WS->Distance;
+  Vertex          *predecessor = WS->Predecessor;
+  int              currentV;
 
   //
-  // for each vertex, add to Queue to be visited,
-  // initialize distance to Infinity, and set predecessor
-  // to -1:
+  // starting vertex has a distance of 0 from itself, and is
+  // the first vertex to explore:
   //
-  Queue *unvisitedQ = CreateQueue(N);
-  int currentV;
+  PQueue *unvisitedPQ = WS->PQ;
 
-  for (currentV = 0; currentV < N; ++currentV)
-  {
-    Enqueue(unvisitedQ, currentV);
-    distance[currentV] = INF; 
-    predecessor[currentV] = -1;
-  }
+  int     dequeued = 0, expanded = 0, peak = 0;
+  long    scanned = 0, relaxed = 0;
 
-  //
-  // starting vertex has a distance of 0 from itself:
-  //
+  stamp[src] = epoch;
   distance[src] = 0;
+  predecessor[src] = -1;
+
+  if (SameComponent(G, src, dest))  // else there's no path, don't search:
+    PQInsert(unvisitedPQ, src, 0);
 
   //
   // Now run Dijkstra's algorithm:
   //
-  while (!isEmptyQueue(unvisitedQ))
+  while (!isEmptyPQueue(unvisitedPQ))
   {
     //
-    // find the vertex with the smallest distance from
-    // the start, that's the vertex to explore next:
+    // the vertex with the smallest distance from the start
+    // is the vertex to explore next:
     //
-    currentV = PopMin(unvisitedQ, distance);
+    if (unvisitedPQ->NumElements > peak)
+      peak = unvisitedPQ->NumElements;
 
-    // is there a path to the current vertex?  if not, 
-    // there's no point in looking at neighbors...
-    if (distance[currentV] == INF)
+    currentV = PQPopMin(unvisitedPQ);
+    ++dequeued;
+
+    // once dest is settled, its shortest path is known:
+    if (currentV == dest)
       break;
 
+    ++expanded;
+
     //
-    // now see if we have found any shorter paths for minV's
+    // now see if we have found any shorter paths for currentV's
     // neighboring vertices:
     //
-    Vertex *neighbors = Neighbors(G, currentV);
+    NeighborSpan neighbors = NeighborsOf(G, currentV);
+    scanned += neighbors.Count;
 
-    int i = 0;
-    while (neighbors[i] != -1)  // for each neighbor:
+    int i;
+    for (i = 0; i < neighbors.Count; ++i)  // for each neighbor:
     {
-      int adjV = neighbors[i];
+      int adjV = neighbors.Vertices[i];
 
-      int edgeWeight = getEdgeWeight(G, currentV, adjV);
+      int edgeWeight = neighbors.Weights[i];
       int altDistance = distance[currentV] + edgeWeight;
 
-      if (altDistance < distance[adjV])
+      if (stamp[adjV] != epoch || altDistance < distance[adjV])
       {
+        stamp[adjV] = epoch;
         distance[adjV] = altDistance;
         predecessor[adjV] = currentV;
-      }
+        ++relaxed;
 
-      ++i;
+        PQInsert(unvisitedPQ, adjV, altDistance);  // insert or decrease-key:
+      }
     }
-
-    free(neighbors);
   }
 
   //
   // Okay, algorithm has run to completion, and the path (if
-  // any) is stored backwards in predecessor array.  So let's 
-  // use a stack to reverse it:
+  // any) is stored backwards in predecessor array:
   //
-  Stack *S = CreateStack(N);
+  Vertex *path = _pathTo(WS, src, dest);
 
-  int v = dest;
-  while (predecessor[v] != -1)
+  //
+  // done!  leave the queue empty for the next search:
+  //
+  ClearPQueue(unvisitedPQ);
+  EndSearch(WS, W);
+
+  if (stats != NULL)
   {
-    Push(S, v);
-    v = predecessor[v];
+    stats->VerticesDequeued = dequeued;
+    stats->VerticesExpanded = expanded;
+    stats->EdgesScanned = scanned;
+    stats->Relaxations = relaxed;
+    stats->PeakFrontier = peak;
+    EndSearchStats(stats);
   }
 
-  // loop stops when it gets to src, so push src to finish:
-  Push(S, src);
+  return path;
+}
+
+
+//
+// _hamming:
+//
+// Returns the # of positions at which words a and b differ, or 0
+// if they have different lengths.
+//
+static int _hamming(char *a, char *b)
+{
+  int  differ = 0;
+
+  for (; *a != '\0' && *b != '\0'; ++a, ++b)
+  {
+    if (*a != *b)
+      ++differ;
+  }
+
+  if (*a != *b)  // different lengths:
+    return 0;
+
+  return differ;
+}
+
+//
+// AStar:
+//
+// Same as Dijkstra(), and returns the same kind of path array, but
+// explores vertices in order of distance-so-far plus an estimate of
+// the distance remaining:  the # of letters in which the vertex's
+// word differs from dest's word.  Since every edge changes exactly
+// one letter and has weight >= 1, the estimate never overshoots, and
+// the path found is a shortest one.  Among vertices with the same
+// estimated total, the one closest to dest is explored first.
+//
+// stats and W are as for Dijkstra().
+//
+// NOTE: the graph must be frozen (see FreezeGraph), and be a word
+// graph in the sense above; distances must stay below INT_MAX / 64.
+//
+// NOTE: returns NULL if src or dest are not valid vertex ids.
+//
+// NOTE: it is the responsibility of the CALLER to free the 
+// returned array when they are done.
+//
+Vertex *AStar(Graph *G, Vertex src, Vertex dest, SearchStats *stats, SearchWorkspace *W)
+{
+  int  INF = INT_MAX;
+
+  if (src < 0 || src >= G->NumVertices)  // invalid vertex #:
+    return NULL;
+  if (dest < 0 || dest >= G->NumVertices)  // invalid vertex #:
+    return NULL;
+
+  if (stats != NULL)
+    BeginSearchStats(stats);
+
+  SearchWorkspace *WS = StartSearch(W, G->NumVertices);
+  unsigned int     epoch = WS->Epoch;
+  unsigned int    *stamp = WS->Stamp;  // unstamped => distance Infinity
+  int             *distance = WS->Distance;
+  Vertex          *predecessor = WS->Predecessor;
+  int              currentV;
 
   //
-  // at this point we have the path on the stack, or if there's
-  // no path, just src is on the stack.  Allocated an array and
-  // fill with path, or if no path, just -1:
+  // queue priority is (distance + estimate) * 64 + estimate, so
+  // ties on the total go to the smaller estimate:
   //
-  Vertex  *path;
+  char   *destName = Vertex2Name(G, dest);
+  PQueue *openPQ = WS->PQ;
+  int     dequeued = 0, expanded = 0, peak = 0;
+  long    scanned = 0, relaxed = 0;
+  int     h = _hamming(Vertex2Name(G, src), destName);
 
-  if (S->NumElements == 1) // just src on stack, no path:
-  {
-    N = 1;  // just the -1:
+  stamp[src] = epoch;
+  distance[src] = 0;
+  predecessor[src] = -1;
 
-    path = (Vertex *)malloc(N * sizeof(Vertex));
-    if (path == NULL)
-    {
-      printf("\n**Error in Dijkstra: malloc failed to allocate\n\n");
-      exit(-1);
-    }
+  if (SameComponent(G, src, dest))  // else there's no path, don't search:
+    PQInsert(openPQ, src, h * 64 + (h < 63 ? h : 63));
 
-    path[0] = -1;  // no path from src to dest:
-  }
-  else
+  while (!isEmptyPQueue(openPQ))
   {
-    N = S->NumElements + 1;  // path + -1 at the end
+    if (openPQ->NumElements > peak)
+      peak = openPQ->NumElements;
 
-    path = (Vertex *)malloc(N * sizeof(Vertex));
-    if (path == NULL)
-    {
-      printf("\n**Error in Dijkstra: malloc failed to allocate\n\n");
-      exit(-1);
-    }
+    currentV = PQPopMin(openPQ);
+    ++dequeued;
+
+    // once dest is settled, its shortest path is known:
+    if (currentV == dest)
+      break;
+
+    ++expanded;
 
-    // now empty the stack into the path array:
-    int i = 0;
-    while (!isEmptyStack(S))
+    NeighborSpan neighbors = NeighborsOf(G, currentV);
+    scanned += neighbors.Count;
+
+    int i;
+    for (i = 0; i < neighbors.Count; ++i)  // for each neighbor:
     {
-      path[i] = Pop(S);
-      ++i;
-    }
+      int adjV = neighbors.Vertices[i];
+      int altDistance = distance[currentV] + neighbors.Weights[i];
 
-    path[i] = -1;  // need -1 terminator at the end:
+      if (stamp[adjV] != epoch || altDistance < distance[adjV])
+      {
+        stamp[adjV] = epoch;
+        distance[adjV] = altDistance;
+        predecessor[adjV] = currentV;
+        ++relaxed;
+
+        h = _hamming(Vertex2Name(G, adjV), destName);
+
+        if (altDistance + h >= INF / 64)
+        {
+          printf("\n**Error in AStar: distance too large.\n\n");
+          exit(-1);
+        }
+
+        // insert or decrease-key:
+        PQInsert(openPQ, adjV, (altDistance + h) * 64 + (h < 63 ? h : 63));
+      }
+    }
   }
 
+  Vertex *path = _pathTo(WS, src, dest);
+
   //
-  // done!
+  // done!  leave the queue empty for the next search:
   //
-  DeleteStack(S);
-  DeleteQueue(unvisitedQ);
-  free(distance); 
-  free(predecessor);
+  ClearPQueue(openPQ);
+  EndSearch(WS, W);
+
+  if (stats != NULL)
+  {
+    stats->VerticesDequeued = dequeued;
+    stats->VerticesExpanded = expanded;
+    stats->EdgesScanned = scanned;
+    stats->Relaxations = relaxed;
+    stats->PeakFrontier = peak;
+    EndSearchStats(stats);
+  }
 
   return path;
 }
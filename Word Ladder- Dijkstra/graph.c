@@ -8,14 +8,18 @@
 #include <math.h>
 #include <assert.h>
 
-#include "avl.h"
+#include "nameindex.h"
 #include "stack.h"
 #include "queue.h"
 #include "set.h"
+#include "workspace.h"
 #include "graph.h"
+#include "snapshot.h"
 #include "mymem.h"
+#include "timer.h"
 #include "limits.h"
 
+#define EDGES_PER_CHUNK  4096  // Edge nodes allocated at a time
 
 // #####################################################
 //
@@ -63,23 +67,36 @@ Graph *CreateGraph(int N)
   for (i = 0; i < N; ++i)  // initialize to empty lists:
     G->Vertices[i] = NULL;
 
+  G->EdgePool = mypool_create(sizeof(Edge), EDGES_PER_CHUNK);
+
   //
   // allocate array for storing vertex names:
   //
-  G->Names = (char **)mymalloc(N * sizeof(char *));
-  G->NamesTree = NULL;
-  if (G->Names == NULL)
+  G->NameCharsCapacity = 8 * N;  // room for names of ~7 letters:
+  G->NameChars = (char *)mymalloc(G->NameCharsCapacity * sizeof(char));
+  G->NameOffsets = (int *)mymalloc((N + 1) * sizeof(int));
+  G->NamesIndex = CreateNameIndex(N);
+  if (G->NameChars == NULL || G->NameOffsets == NULL || G->NamesIndex == NULL)
   {
     printf("\n**Error in CreateGraph: malloc failed to allocate\n\n");
     exit(-1);
   }
 
-  for (i = 0; i < N; ++i)  // initialize to empty names:
-    G->Names[i] = NULL;
+  G->NameOffsets[0] = 0;  // arena is empty:
 
   //
   // graph is empty to start --- initialize remaining fields:
   //
+  G->Offsets = NULL;
+  G->Dests = NULL;
+  G->Weights = NULL;
+  G->Frozen = 0;  /*false*/
+  G->Symmetric = 0;  /*false*/
+  G->Component = NULL;
+  G->ComponentSizes = NULL;
+  G->NumComponents = 0;
+  G->Snapshot = NULL;
+  G->SnapshotSize = 0;
   G->NumVertices = 0;
   G->NumEdges = 0;
   G->Capacity = N;
@@ -97,128 +114,232 @@ Graph *CreateGraph(int N)
 //
 void DeleteGraph(Graph *G)
 {
-  int  i;
-  
   //
-  // Every vertex has a name, and a list of edges.  Free
-  // that memory:
+  // A graph loaded from a snapshot only owns the name index
+  // header, the rest is in the mapped file:
   //
-  for (i = 0; i < G->NumVertices; ++i)
+  if (G->Snapshot != NULL)
   {
-    // free vertex name:
-    myfree(G->Names[i]);
-
-    // free each edge:
-    Edge *cur, *temp;
-    cur = G->Vertices[i];
-    while (cur != NULL)
-    {
-      temp = cur;
-      cur = cur->next;
+    UnmapGraphSnapshot(G);
 
-      myfree(temp);
-    }
+    myfree(G->NamesIndex);
+    myfree(G);
+    return;
+  }
+  
+  //
+  // Unless the graph has been frozen, every vertex has a list
+  // of edges; the edges are all in the pool, free them at once:
+  //
+  if (G->Frozen)
+  {
+    myfree(G->Offsets);
+    myfree(G->Dests);
+    myfree(G->Weights);
+    myfree(G->Component);
+    myfree(G->ComponentSizes);
+  }
+  else
+  {
+    mypool_delete(G->EdgePool);
+    myfree(G->Vertices);
   }
 
-  // free the arrays we just traversed:
-  myfree(G->Vertices);
-  myfree(G->Names);
+  // the names are all in one arena:
+  myfree(G->NameChars);
+  myfree(G->NameOffsets);
 
-  
-  FreeAVLTree(G->NamesTree);
+  DeleteNameIndex(G->NamesIndex);
 
   // free head node:
   myfree(G);
 }
 
 //
-// AddVertex:
+// _growVertices:
 //
-// Adds a vertex with the given name to G, returning a unique integer id
-// identifying this vertex.  Returns -1 if adding the vertex failed, i.e.
-// if the graph is full and additional vertices cannot be created; this
-// occurs when the graph's capacity is reached.
+// Grows G's per-vertex arrays (name offsets and edge lists) to a
+// capacity of N vertices, copying the existing entries over.
 //
-int AddVertex(Graph *G, char *name)
+static void _growVertices(Graph *G, int N)
 {
-  int v = G->NumVertices;  // next free location:
+  //
+  // first we'll grow the array of name offsets:
+  //
+  int *newOffsets = (int *)mymalloc((N + 1) * sizeof(int));
+  if (newOffsets == NULL)
+  {
+    printf("\n**Error in AddVertex: malloc failed to allocate\n\n");
+    exit(-1);
+  }
 
-  if (G->NumVertices == G->Capacity)  // graph is full:
+  // copy existing offsets over:
+  int  i;
+
+  for (i = 0; i <= G->NumVertices; ++i)
   {
-    // we need to dynamically grow, so let's double in size:
-    int N = 2 * G->Capacity;
+    newOffsets[i] = G->NameOffsets[i];
+  }
 
-    //
-    // first we'll grow the array of names:
-    //
-    char **newNames = (char **)mymalloc(N * sizeof(char *));
-    if (newNames == NULL)
-    {
-      printf("\n**Error in AddVertex: malloc failed to allocate\n\n");
-      exit(-1);
-    }
+  myfree(G->NameOffsets);
 
-    // copy existing names over:
-    int  i;
+  //
+  // now we need to grow the edge lists:
+  //
+  Edge **newVertices = (Edge **)mymalloc(N * sizeof(Edge *));
+  if (newVertices == NULL)
+  {
+    printf("\n**Error in AddVertex: malloc failed to allocate\n\n");
+    exit(-1);
+  }
 
-    for (i = 0; i < G->NumVertices; ++i)
-    {
-      newNames[i] = G->Names[i];
-    }
+  // copy existing edge lists:
+  for (i = 0; i < G->NumVertices; ++i)
+  {
+    newVertices[i] = G->Vertices[i];
+  }
 
-    myfree(G->Names);
+  myfree(G->Vertices);
 
-    //
-    // now we need to grow the edge lists:
-    //
-    Edge **newVertices = (Edge **)mymalloc(N * sizeof(Edge *));
-    if (newVertices == NULL)
-    {
-      printf("\n**Error in AddVertex: malloc failed to allocate\n\n");
-      exit(-1);
-    }
+  //
+  // done, update graph header:
+  //
+  G->NameOffsets = newOffsets;
+  G->Vertices = newVertices;
+  G->Capacity = N;
+}
 
-    // copy existing edge lists:
-    for (i = 0; i < G->NumVertices; ++i)
-    {
-      newVertices[i] = G->Vertices[i];
-    }
+//
+// _growNameChars:
+//
+// Makes room for size more chars at the end of G's name arena,
+// doubling the arena as many times as needed.
+//
+static void _growNameChars(Graph *G, int size)
+{
+  int  start = G->NameOffsets[G->NumVertices];
 
-    myfree(G->Vertices);
+  if (start + size <= G->NameCharsCapacity)  // fits already:
+    return;
 
-    //
-    // done, update graph header:
-    //
-    G->Names = newNames;
-    G->Vertices = newVertices;
-    G->Capacity = N;
-  }
+  int   newCapacity = 2 * G->NameCharsCapacity;
 
-  // initialize edge list to empty:
-  G->Vertices[v] = NULL;
+  while (start + size > newCapacity)
+    newCapacity *= 2;
 
-  // make a copy of the name:
-  G->Names[v] = (char *)mymalloc(((int)(strlen(name) + 1)) * sizeof(char));
-  if (G->Names[v] == NULL)
+  char *newChars = (char *)mymalloc(newCapacity * sizeof(char));
+  if (newChars == NULL)
   {
     printf("\n**Error in AddVertex: malloc failed to allocate\n\n");
     exit(-1);
   }
 
-  strcpy(G->Names[v], name);
+  memcpy(newChars, G->NameChars, start);
+  myfree(G->NameChars);
+
+  G->NameChars = newChars;
+  G->NameCharsCapacity = newCapacity;
+}
+
+//
+// AddVertex:
+//
+// Adds a vertex with the given name to G, returning a unique integer id
+// identifying this vertex.  Returns -1 if adding the vertex failed, i.e.
+// if the graph has been frozen.  The graph grows dynamically, doubling
+// in capacity whenever it becomes full.
+//
+int AddVertex(Graph *G, char *name)
+{
+  int v = G->NumVertices;  // next free location:
+
+  if (G->Frozen)  // no more vertices once frozen:
+    return -1;
+
+  if (G->NumVertices == G->Capacity)  // graph is full, double in size:
+    _growVertices(G, 2 * G->Capacity);
+
+  // initialize edge list to empty:
+  G->Vertices[v] = NULL;
+
+  // append a copy of the name to the arena, doubling it if full:
+  int  start = G->NameOffsets[v];
+  int  size = (int)strlen(name) + 1;
+
+  _growNameChars(G, size);
+
+  memcpy(G->NameChars + start, name, size);
+  G->NameOffsets[v + 1] = start + size;
 
   // one more vertex now:
   G->NumVertices++;
-  
-  AVLElementType T;
-  T.Vertex = v;
-  strcpy(T.Word, name);
-  G->NamesTree = Insert(G->NamesTree, T);
-  
+
+  // index by name; if the name is a duplicate, lookups keep
+  // finding the first vertex with that name:
+  NameIndexInsert(G->NamesIndex, G->NameChars, G->NameOffsets, v);
+
   // done!  Return vertex's number:
   return v;
 }
 
+//
+// AddVertices:
+//
+// Adds n vertices at once, named by the n '\0'-terminated strings
+// stored back to back in names, e.g. a dictionary as read from its
+// file; the result is the same as n calls to AddVertex, but the
+// arrays and the arena grow (at most) once, the names are copied
+// with one memcpy, and sorted names are indexed in bulk (see
+// NameIndexInsertRange).  Returns the id of the first new vertex,
+// or -1 if the graph has been frozen.
+//
+int AddVertices(Graph *G, char *names, int n)
+{
+  int  first = G->NumVertices;
+  int  i;
+
+  if (G->Frozen)  // no more vertices once frozen:
+    return -1;
+
+  if (first + n > G->Capacity)  // grow, doubling, just once:
+  {
+    int N = 2 * G->Capacity;
+
+    while (first + n > N)
+      N *= 2;
+
+    _growVertices(G, N);
+  }
+
+  //
+  // one pass to set the offsets, which are where the names will be
+  // once the whole block is appended to the arena:
+  //
+  char *name = names;
+
+  for (i = 0; i < n; ++i)
+  {
+    int  size = (int)strlen(name) + 1;
+
+    G->Vertices[first + i] = NULL;
+    G->NameOffsets[first + i + 1] = G->NameOffsets[first + i] + size;
+    name += size;
+  }
+
+  int  start = G->NameOffsets[first];
+  int  size = G->NameOffsets[first + n] - start;
+
+  _growNameChars(G, size);
+
+  memcpy(G->NameChars + start, names, size);
+
+  G->NumVertices += n;
+
+  NameIndexInsertRange(G->NamesIndex, G->NameChars, G->NameOffsets, first, n);
+
+  return first;
+}
+
 //
 // Name2Vertex:
 //
@@ -229,19 +350,19 @@ int AddVertex(Graph *G, char *name)
 int Name2Vertex(Graph *G, char *Name)
 {
   int  i;
-  AVLElementType value;
-  strcpy(value.Word, Name);
-  AVLNode * T = Contains(G->NamesTree, value);
-  if(T != NULL)
-    return T->value.Vertex;
-  return -1;
 
   //
-  // linear search through the Names array:
+  // hash lookup in the name index:
+  //
+  if (G->NamesIndex != NULL)
+    return NameIndexLookup(G->NamesIndex, G->NameChars, G->NameOffsets, Name);
+
+  //
+  // linear search through the names:
   //
   for (i = 0; i < G->NumVertices; ++i)
   {
-    if (strcmp(G->Names[i], Name) == 0)
+    if (strcmp(G->NameChars + G->NameOffsets[i], Name) == 0)
       return i;
   }
 
@@ -253,7 +374,8 @@ int Name2Vertex(Graph *G, char *Name)
 // Vertex2Name:
 //
 // Looks up a vertex by number, returning a pointer to
-// its name; returns NULL if v is invalid.
+// its name in the name arena; returns NULL if v is invalid.
+// The pointer is valid until the next AddVertex.
 //
 // NOTE: do not change the string via the returned 
 // pointer; treat the pointer and the underlying string
@@ -264,7 +386,7 @@ char *Vertex2Name(Graph *G, Vertex v)
   if (v < 0 || v >= G->NumVertices)
     return NULL;
 
-  return G->Names[v];
+  return G->NameChars + G->NameOffsets[v];
 }
 
 //
@@ -272,7 +394,8 @@ char *Vertex2Name(Graph *G, Vertex v)
 //
 // Adds a directed edge (src, dest, weight) to G.  If successful, true
 // (non-zero) is returned; if the edge could not be added (i.e. due to
-// invalid vertex ids), then false (0) is returned.
+// invalid vertex ids, or because the graph is frozen), then false (0)
+// is returned.
 //
 // NOTE: loops and multi-edges are allowed.  To allow easier handling of
 // multi-edges, edges are stored "in order by destination".  So when 
@@ -284,6 +407,8 @@ char *Vertex2Name(Graph *G, Vertex v)
 //
 int AddEdge(Graph *G, Vertex src, Vertex dest, int weight)
 {
+  if (G->Frozen)  // no more edges once frozen:
+    return 0;
   if (src < 0 || src >= G->NumVertices)  // invalid vertex #:
     return 0;
   if (dest < 0 || dest >= G->NumVertices)  // invalid vertex #:
@@ -292,12 +417,7 @@ int AddEdge(Graph *G, Vertex src, Vertex dest, int weight)
   //
   // allocate memory for new edge:
   //
-  Edge *edge = (Edge *)mymalloc(sizeof(Edge));
-  if (edge == NULL)
-  {
-    printf("\n**Error in AddEdge: malloc failed to allocate\n\n");
-    exit(-1);
-  }
+  Edge *edge = (Edge *)mypool_alloc(G->EdgePool);
 
   //
   // store data:
@@ -343,6 +463,236 @@ int AddEdge(Graph *G, Vertex src, Vertex dest, int weight)
   return 1;  // success!
 }
 
+//
+// _findRoot:
+//
+// Union-find:  returns the root of v's tree in parent[], halving
+// the path along the way.
+//
+static int _findRoot(int *parent, int v)
+{
+  while (parent[v] != v)
+  {
+    parent[v] = parent[parent[v]];
+    v = parent[v];
+  }
+
+  return v;
+}
+
+//
+// _labelComponents:
+//
+// Labels the connected components of the frozen graph G, ignoring
+// edge direction (see graph.h).  Each edge unions its endpoints'
+// trees, the smaller tree going under the larger; then one sweep in
+// vertex order numbers the roots as they are first seen.
+//
+static void _labelComponents(Graph *G)
+{
+  int  N = G->NumVertices;
+  int  v, e;
+
+  int *parent = (int *)mymalloc((N + 1) * sizeof(int));  // +1 so N may be 0:
+  int *size = (int *)mymalloc((N + 1) * sizeof(int));
+  G->Component = (int *)mymalloc((N + 1) * sizeof(int));
+
+  if (parent == NULL || size == NULL || G->Component == NULL)
+  {
+    printf("\n**Error in FreezeGraph: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  for (v = 0; v < N; ++v)  // every vertex on its own:
+  {
+    parent[v] = v;
+    size[v] = 1;
+  }
+
+  for (v = 0; v < N; ++v)
+  {
+    for (e = G->Offsets[v]; e < G->Offsets[v + 1]; ++e)
+    {
+      int ru = _findRoot(parent, v);
+      int rv = _findRoot(parent, G->Dests[e]);
+
+      if (ru == rv)  // already connected:
+        continue;
+
+      if (size[ru] < size[rv])
+      {
+        int temp = ru;
+        ru = rv;
+        rv = temp;
+      }
+
+      parent[rv] = ru;
+      size[ru] += size[rv];
+    }
+  }
+
+  //
+  // number the components:  a root's id is stored at Component[root]
+  // when first seen, which may be before the sweep reaches the root:
+  //
+  G->NumComponents = 0;
+
+  for (v = 0; v < N; ++v)
+    G->Component[v] = -1;
+
+  for (v = 0; v < N; ++v)
+  {
+    int r = _findRoot(parent, v);
+
+    if (G->Component[r] == -1)
+    {
+      G->Component[r] = G->NumComponents;
+      size[G->NumComponents] = size[r];  // id <= v, so that slot is no longer needed:
+      G->NumComponents++;
+    }
+
+    G->Component[v] = G->Component[r];
+  }
+
+  G->ComponentSizes = (int *)mymalloc((G->NumComponents + 1) * sizeof(int));
+  if (G->ComponentSizes == NULL)
+  {
+    printf("\n**Error in FreezeGraph: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  memcpy(G->ComponentSizes, size, G->NumComponents * sizeof(int));
+
+  myfree(parent);
+  myfree(size);
+}
+
+//
+// SameComponent:
+//
+// Returns true (non-zero) if u and v are in the same connected
+// component, false (0) if there can be no path between them.  Before
+// the graph is frozen, components are unknown, and this returns true.
+//
+int SameComponent(Graph *G, Vertex u, Vertex v)
+{
+  if (G->Component == NULL)  // not yet known:
+    return 1;  /*true*/
+
+  return G->Component[u] == G->Component[v];
+}
+
+//
+// FreezeGraph:
+//
+// Converts the graph's adjacency lists into compressed sparse row
+// (CSR) form:  one array of NumVertices+1 row offsets, and one
+// contiguous array each for edge destinations and weights.  The
+// edge lists (and their pool) are freed, and traversals from then
+// on walk contiguous memory.  Multi-edges are merged into a single
+// edge with the minimum weight, so NumEdges becomes the # of
+// distinct edges.  The graph is read-only after this call; freezing
+// an already-frozen graph does nothing.
+//
+// Also records whether the graph is symmetric, i.e. every edge
+// u -> v has a reverse edge v -> u; BidirectionalBFS relies on this.
+// Finally, labels the connected components (see graph.h).
+//
+void FreezeGraph(Graph *G)
+{
+  int  v;
+  int  e;
+
+  if (G->Frozen)
+    return;
+
+  G->Offsets = (int *)mymalloc((G->NumVertices + 1) * sizeof(int));
+  G->Dests = (Vertex *)mymalloc((G->NumEdges + 1) * sizeof(Vertex));
+  G->Weights = (int *)mymalloc((G->NumEdges + 1) * sizeof(int));
+
+  if (G->Offsets == NULL || G->Dests == NULL || G->Weights == NULL)
+  {
+    printf("\n**Error in FreezeGraph: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  //
+  // copy each edge list into the next row, freeing the edges as
+  // we go; the lists are already in order by destination, so
+  // multi-edges are next to each other:
+  //
+  e = 0;
+
+  for (v = 0; v < G->NumVertices; ++v)
+  {
+    G->Offsets[v] = e;
+
+    Edge *cur = G->Vertices[v];
+    while (cur != NULL)
+    {
+      if (e > G->Offsets[v] && G->Dests[e - 1] == cur->dest)  // multi-edge:
+      {
+        if (cur->weight < G->Weights[e - 1])
+          G->Weights[e - 1] = cur->weight;
+      }
+      else
+      {
+        G->Dests[e] = cur->dest;
+        G->Weights[e] = cur->weight;
+        ++e;
+      }
+
+      cur = cur->next;
+    }
+  }
+
+  G->Offsets[G->NumVertices] = e;
+  assert(e <= G->NumEdges);
+  G->NumEdges = e;
+
+  mypool_delete(G->EdgePool);  // all the edges:
+  G->EdgePool = NULL;
+
+  myfree(G->Vertices);
+  G->Vertices = NULL;
+
+  G->Frozen = 1;  /*true*/
+
+  //
+  // symmetric?  look up each edge's reverse in the (sorted) row
+  // of its destination:
+  //
+  G->Symmetric = 1;  /*true*/
+
+  for (v = 0; v < G->NumVertices && G->Symmetric; ++v)
+  {
+    for (e = G->Offsets[v]; e < G->Offsets[v + 1]; ++e)
+    {
+      Vertex u = G->Dests[e];
+      int    low = G->Offsets[u];
+      int    high = G->Offsets[u + 1];
+
+      while (low < high)
+      {
+        int mid = low + ((high - low) / 2);
+
+        if (G->Dests[mid] < v)
+          low = mid + 1;
+        else
+          high = mid;
+      }
+
+      if (low == G->Offsets[u + 1] || G->Dests[low] != v)  // no reverse edge:
+      {
+        G->Symmetric = 0;  /*false*/
+        break;
+      }
+    }
+  }
+
+  _labelComponents(G);
+}
+
 //
 // Neighbors:
 //
@@ -367,9 +717,18 @@ Vertex *Neighbors(Graph *G, Vertex v)
     return NULL;
 
   //
-  // allocate array of worst-case size: # of vertices + 1
+  // allocate array of worst-case size: # of edges out of v + 1
   //
-  N = G->NumVertices + 1;
+  if (G->Frozen)
+    N = G->Offsets[v + 1] - G->Offsets[v] + 1;
+  else
+  {
+    Edge *cur;
+
+    N = 1;
+    for (cur = G->Vertices[v]; cur != NULL; cur = cur->next)
+      ++N;
+  }
 
   neighbors = (Vertex *)mymalloc(N * sizeof(Vertex));
   if (neighbors == NULL)
@@ -379,35 +738,39 @@ Vertex *Neighbors(Graph *G, Vertex v)
   }
 
   //
-  // Now loop through the list of edges and copy the dest 
-  // vertex of each edge:
+  // Now copy the dest vertex of each edge.  Once frozen, the
+  // neighbors are already stored without multi-edges:
   //
-  Edge *cur = G->Vertices[v];
-
   i = 0;
-  while (cur != NULL)  // for each edge out of v:
+
+  if (G->Frozen)  // copy v's row in CSR form:
+  {
+    NeighborSpan span = NeighborsOf(G, v);
+
+    for (i = 0; i < span.Count; ++i)
+      neighbors[i] = span.Vertices[i];
+  }
+  else  // walk v's edge list:
   {
     //
-    // the dest is our neighbor --- however, we have to be 
+    // The dest is our neighbor --- however, we have to be 
     // careful of multi-edges, i.e. edges with the same dest.
     // Since edges are stored in order, edges with same dest
-    // appear next to each other in the list --- so look to
-    // see if array already contains dest before we copy over:
+    // appear next to each other --- so look to see if array
+    // already contains dest before we copy over:
     //
-    if (i == 0)  // first neighbor, we always copy:
-    {
-      neighbors[i] = cur->dest;
-      ++i;
-    }
-    else if (neighbors[i - 1] != cur->dest)  // make sure not a multi-edge:
+    Edge *cur = G->Vertices[v];
+
+    while (cur != NULL)  // for each edge out of v:
     {
-      neighbors[i] = cur->dest;
-      ++i;
-    }
-    else // multi-edge, so ignore:
-      ;
+      if (i == 0 || neighbors[i - 1] != cur->dest)  // not a multi-edge:
+      {
+        neighbors[i] = cur->dest;
+        ++i;
+      }
 
-    cur = cur->next;
+      cur = cur->next;
+    }
   }
 
   //
@@ -418,6 +781,44 @@ Vertex *Neighbors(Graph *G, Vertex v)
   return neighbors;
 }
 
+//
+// NeighborsOf:
+//
+// Returns a span over the neighbors of v in a frozen graph, in
+// ascending order and without multi-edges, along with the edge
+// weights.  Unlike Neighbors(), nothing is allocated:  the span
+// points into the graph, so treat it as read-only and do not free
+// it.  If v is not a valid vertex id, the span is empty.
+//
+// NOTE: the graph must be frozen (see FreezeGraph); otherwise an
+// error message is printed and the program is exited.
+//
+NeighborSpan NeighborsOf(Graph *G, Vertex v)
+{
+  NeighborSpan span;
+
+  if (!G->Frozen)
+  {
+    printf("\n**Error in NeighborsOf: graph is not frozen.\n\n");
+    exit(-1);
+  }
+
+  if (v < 0 || v >= G->NumVertices)  // invalid vertex #:
+  {
+    span.Vertices = NULL;
+    span.Weights = NULL;
+    span.Count = 0;
+
+    return span;
+  }
+
+  span.Vertices = &G->Dests[G->Offsets[v]];
+  span.Weights = &G->Weights[G->Offsets[v]];
+  span.Count = G->Offsets[v + 1] - G->Offsets[v];
+
+  return span;
+}
+
 ///
 // Prints the graph for debugging purposes.  Pass true
 // (non-zero) for the "complete" parameter to dump complete
@@ -430,6 +831,22 @@ void PrintGraph(Graph *G, char *title, int complete)
   printf("  # of vertices: %d\n", G->NumVertices);
   printf("  # of edges:    %d\n", G->NumEdges);
 
+  if (G->Component != NULL)
+  {
+    int  c, largest = 0, isolated = 0;
+
+    for (c = 0; c < G->NumComponents; ++c)
+    {
+      if (G->ComponentSizes[c] > largest)
+        largest = G->ComponentSizes[c];
+      if (G->ComponentSizes[c] == 1)
+        ++isolated;
+    }
+
+    printf("  # of components: %d (largest: %d vertices, isolated: %d)\n",
+      G->NumComponents, largest, isolated);
+  }
+
   // is a complete print desired?  if not, return now:
   if (!complete)
     return;
@@ -442,16 +859,31 @@ void PrintGraph(Graph *G, char *title, int complete)
   int  v;
   for (v = 0; v < G->NumVertices; ++v)
   {
-    printf("   %d (%s): ", v, G->Names[v]);
+    printf("   %d (%s): ", v, Vertex2Name(G, v));
+
+    if (G->Frozen)
+    {
+      int  e;
+
+      for (e = G->Offsets[v]; e < G->Offsets[v + 1]; ++e)
+      {
+        printf("(%d,%d,%d)", v, G->Dests[e], G->Weights[e]);
 
-    Edge *edge = G->Vertices[v];
-    while (edge != NULL)
+        if (e + 1 < G->Offsets[v + 1])
+          printf(", ");
+      }
+    }
+    else
     {
-      printf("(%d,%d,%d)", edge->src, edge->dest, edge->weight);
+      Edge *edge = G->Vertices[v];
+      while (edge != NULL)
+      {
+        printf("(%d,%d,%d)", edge->src, edge->dest, edge->weight);
 
-      edge = edge->next;
-      if (edge != NULL)
-        printf(", ");
+        edge = edge->next;
+        if (edge != NULL)
+          printf(", ");
+      }
     }
 
     printf("\n");
@@ -464,7 +896,7 @@ void PrintGraph(Graph *G, char *title, int complete)
 
   for (v = 0; v < G->NumVertices; ++v)
   {
-    printf("   %d (%s): ", v, G->Names[v]);
+    printf("   %d (%s): ", v, Vertex2Name(G, v));
 
     Vertex *neighbors = Neighbors(G, v);
 
@@ -486,15 +918,17 @@ void PrintGraph(Graph *G, char *title, int complete)
   }
 
   //
-  // BFS:
+  // BFS:  one workspace serves every search:
   //
+  SearchWorkspace *W = CreateSearchWorkspace(G->NumVertices);
+
   printf("  BFS:\n");
 
   for (v = 0; v < G->NumVertices; ++v)
   {
-    printf("   %d (%s): ", v, G->Names[v]);
+    printf("   %d (%s): ", v, Vertex2Name(G, v));
 
-    Vertex *visited = BFS(G, v);
+    Vertex *visited = BFS(G, v, NULL, W);
 
     if (visited == NULL)
       printf("**ERROR: BFS returned NULL.\n\n");
@@ -520,9 +954,9 @@ void PrintGraph(Graph *G, char *title, int complete)
 
   for (v = 0; v < G->NumVertices; ++v)
   {
-    printf("   %d (%s): ", v, G->Names[v]);
+    printf("   %d (%s): ", v, Vertex2Name(G, v));
 
-    Vertex *visited = DFS(G, v);
+    Vertex *visited = DFS(G, v, NULL, W);
 
     if (visited == NULL)
       printf("**ERROR: DFS returned NULL.\n\n");
@@ -541,6 +975,42 @@ void PrintGraph(Graph *G, char *title, int complete)
     }
   }
 
+  DeleteSearchWorkspace(W);
+}
+
+//
+// BeginSearchStats / EndSearchStats:
+//
+// Called by a search that was given stats, at its start and end:
+// Begin zeroes the counters and notes the time and allocation count
+// so far, End turns those into the search's elapsed time and # of
+// allocations.  The search fills in the other counters.
+//
+void BeginSearchStats(SearchStats *stats)
+{
+  memset(stats, 0, sizeof(SearchStats));
+
+  stats->Allocations = mymem_thread_malloc_count();
+  stats->Nanos = timer_nanos();
+}
+
+void EndSearchStats(SearchStats *stats)
+{
+  stats->Allocations = mymem_thread_malloc_count() - stats->Allocations;
+  stats->Nanos = timer_nanos() - stats->Nanos;
+}
+
+//
+// PrintSearchStats:
+//
+// Prints the counters, for the interactive app.
+//
+void PrintSearchStats(SearchStats *stats)
+{
+  printf("   Stats:  %d dequeued, %d expanded, %ld edges scanned, %ld relaxations,\n",
+    stats->VerticesDequeued, stats->VerticesExpanded, stats->EdgesScanned, stats->Relaxations);
+  printf("           peak frontier %d, %ld allocations, %lld ns\n",
+    stats->PeakFrontier, stats->Allocations, stats->Nanos);
 }
 
 //
@@ -555,77 +1025,92 @@ void PrintGraph(Graph *G, char *title, int complete)
 // order; no vertex is visited more than once, even in the 
 // presence of cycles and multi-edges.
 //
+// If stats is not NULL, the search's counters are stored there (see
+// SearchStats).  W is the search workspace (see workspace.h); pass
+// NULL to use a temporary one.
+//
 // NOTE: returns NULL if v is not a valid vertex id.
 //
 // NOTE: it is the responsibility of the CALLER to free the 
 // returned array when they are done.
 //
-Vertex *BFS(Graph *G, Vertex v)
+Vertex *BFS(Graph *G, Vertex v, SearchStats *stats, SearchWorkspace *W)
 {
   Vertex *visited;
-  int     N;
-  int     i;
+  int     head, tail;
+  long    scanned = 0;
+  int     peak = 1;
 
   if (v < 0 || v >= G->NumVertices)  // invalid vertex #:
     return NULL;
 
-  //
-  // allocate array of worst-case size: # of vertices + 1
-  //
-  N = G->NumVertices + 1;
+  if (stats != NULL)
+    BeginSearchStats(stats);
 
-  visited = (Vertex *)mymalloc(N * sizeof(Vertex));
-  if (visited == NULL)
-  {
-    printf("\n**Error in BFS: malloc failed to allocate\n\n");
-    exit(-1);
-  }
+  SearchWorkspace *WS = StartSearch(W, G->NumVertices);
+  unsigned int     epoch = WS->Epoch;
+  unsigned int    *stamp = WS->Stamp;  // stamped => discovered
+  Vertex          *order = WS->Order;
 
   //
-  // Perform BFS, starting at given vertex v:
+  // Perform BFS, starting at given vertex v; vertices are visited
+  // in the order they are discovered, so order[] is both the queue
+  // (order[head..tail-1]) and the visited list (order[0..tail-1]):
   //
-  Queue *frontierQ = CreateQueue(N);
-  Set   *discoveredSet = CreateSet(N);
+  order[0] = v;
+  stamp[v] = epoch;
+  head = 0;
+  tail = 1;
 
-  if (!Enqueue(frontierQ, v)) { printf("Error!\n"); exit(-1); }
-  if (!AddToSet(discoveredSet, v)) { printf("Error!\n"); exit(-1); }
-
-  i = 0;  // index into visited of where next vertex goes:
-
-  while (!isEmptyQueue(frontierQ))
+  while (head < tail)
   {
-    Vertex currentV = Dequeue(frontierQ);
-
-    // visit:  add to visited list:
-    visited[i] = currentV;
-    ++i;
+    Vertex currentV = order[head];
+    ++head;
 
-    Vertex *neighbors = Neighbors(G, currentV);
+    NeighborSpan neighbors = NeighborsOf(G, currentV);
+    scanned += neighbors.Count;
 
-    int j = 0;  // index into array of neighbors:
-    while (neighbors[j] != -1)
+    int j;  // index into span of neighbors:
+    for (j = 0; j < neighbors.Count; ++j)
     {
-      Vertex adjV = neighbors[j];
+      Vertex adjV = neighbors.Vertices[j];
 
-      if (!isElementInSet(discoveredSet, adjV))
+      if (stamp[adjV] != epoch)
       {
-        if (!Enqueue(frontierQ, adjV)) { printf("Error!\n"); exit(-1); }
-        if (!AddToSet(discoveredSet, adjV)) { printf("Error!\n"); exit(-1); }
+        stamp[adjV] = epoch;
+        order[tail] = adjV;
+        ++tail;
       }
-
-      ++j;
     }
 
-    myfree(neighbors);
+    if (tail - head > peak)
+      peak = tail - head;
   }//while
 
-   //
-   // done:
-   //
-  visited[i] = -1;  // mark end of vertices with -1:
+  //
+  // done:  copy out the visited vertices, and mark the end with -1:
+  //
+  visited = (Vertex *)mymalloc((tail + 1) * sizeof(Vertex));
+  if (visited == NULL)
+  {
+    printf("\n**Error in BFS: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  memcpy(visited, order, tail * sizeof(Vertex));
+  visited[tail] = -1;
+
+  EndSearch(WS, W);
 
-  DeleteQueue(frontierQ);
-  DeleteSet(discoveredSet);
+  if (stats != NULL)  // every vertex discovered is expanded:
+  {
+    stats->VerticesDequeued = tail;
+    stats->VerticesExpanded = tail;
+    stats->EdgesScanned = scanned;
+    stats->Relaxations = tail - 1;
+    stats->PeakFrontier = peak;
+    EndSearchStats(stats);
+  }
 
   return visited;
 }
@@ -648,17 +1133,25 @@ Vertex *BFS(Graph *G, Vertex v)
 // processed.  Then stop.  Example: d=2 => 3 markers, 
 // after step 0, step 1, and step 2.
 //
+// If stats is not NULL, the search's counters are stored there (see
+// SearchStats).  W is the search workspace (see workspace.h); pass
+// NULL to use a temporary one.
+//
 // NOTE: returns NULL if v is not a valid vertex id, or
 // if distance < 1.
 //
 // NOTE: it is the responsibility of the CALLER to free the 
 // returned array when they are done.
 //
-Vertex *BFSd(Graph *G, Vertex v, int distance)
+Vertex *BFSd(Graph *G, Vertex v, int distance, SearchStats *stats, SearchWorkspace *W)
 {
   Vertex *visited;
-  int     N;
-  int     i;
+  int     start, tail;
+  int     level, numLevels;
+  int     i, k;
+  int     expanded = 0;
+  long    scanned = 0;
+  int     peak = 1;
 
   if (v < 0 || v >= G->NumVertices)  // invalid vertex #:
     return NULL;
@@ -666,82 +1159,108 @@ Vertex *BFSd(Graph *G, Vertex v, int distance)
   if (distance < 1)
     return NULL;
 
-  //
-  // allocate array of worst-case size: # of vertices + distance + 1
-  //
-  N = G->NumVertices + distance + 1;
+  if (stats != NULL)
+    BeginSearchStats(stats);
 
-  visited = (Vertex *)mymalloc(N * sizeof(Vertex));
-  if (visited == NULL)
-  {
-    printf("\n**Error in BFS: malloc failed to allocate\n\n");
-    exit(-1);
-  }
+  SearchWorkspace *WS = StartSearch(W, G->NumVertices);
+  unsigned int     epoch = WS->Epoch;
+  unsigned int    *stamp = WS->Stamp;  // stamped => discovered
+  Vertex          *order = WS->Order;
+  int             *levelEnd = WS->Order2;
 
   //
-  // Perform BFS, starting at given vertex v:
+  // Perform BFS, starting at given vertex v, one level at a time;
+  // level L is order[levelEnd[L-1]..levelEnd[L]-1].  Levels 0..d-1
+  // are expanded, which discovers everything up to d steps away:
   //
-  Queue *frontierQ = CreateQueue(N);
-  Set   *discoveredSet = CreateSet(N);
-
-  if (!Enqueue(frontierQ, v)) { printf("Error!\n"); exit(-1); }
-  if (!AddToSet(discoveredSet, v)) { printf("Error!\n"); exit(-1); }
-
-  i = 0;  // index into visited of where next vertex goes:
-
-  Enqueue(frontierQ, -1);
+  order[0] = v;
+  stamp[v] = epoch;
+  start = 0;
+  tail = 1;
+  numLevels = 0;
 
-  while (!isEmptyQueue(frontierQ))
+  while (numLevels <= distance && start < tail)
   {
+    int end = tail;  // this level is order[start..end-1]:
 
-    if (frontierQ->Elements[frontierQ->Front] == -1)
-    {
-      visited[i] = -1;
-      ++i;
-
-      distance--;
-      if (distance < 0)
-        break;
+    levelEnd[numLevels] = end;
+    numLevels++;
 
-      Dequeue(frontierQ);
-      Enqueue(frontierQ, -1);
+    if (numLevels <= distance)  // expand to discover the next level:
+    {
+      for (k = start; k < end; ++k)
+      {
+        NeighborSpan neighbors = NeighborsOf(G, order[k]);
+        scanned += neighbors.Count;
+
+        int j;  // index into span of neighbors:
+        for (j = 0; j < neighbors.Count; ++j)
+        {
+          Vertex adjV = neighbors.Vertices[j];
+
+          if (stamp[adjV] != epoch)
+          {
+            stamp[adjV] = epoch;
+            order[tail] = adjV;
+            ++tail;
+          }
+        }
+
+        if (tail - k - 1 > peak)  // rest of this level, plus next:
+          peak = tail - k - 1;
+      }
 
-      continue;  // skip loop body and repeat:
+      expanded += end - start;
     }
 
-    Vertex currentV = Dequeue(frontierQ);
+    start = end;
+  }//while
 
-    // visit:  add to visited list:
-    visited[i] = currentV;
-    ++i;
+  //
+  // done:  copy out levels 0..d, each followed by a -1 marker (the
+  // levels beyond the last one discovered are empty), and then mark
+  // the end with another -1:
+  //
+  visited = (Vertex *)mymalloc((tail + distance + 2) * sizeof(Vertex));
+  if (visited == NULL)
+  {
+    printf("\n**Error in BFSd: malloc failed to allocate\n\n");
+    exit(-1);
+  }
 
-    Vertex *neighbors = Neighbors(G, currentV);
+  i = 0;  // index into visited of where next vertex goes:
+  start = 0;
 
-    int j = 0;  // index into array of neighbors:
-    while (neighbors[j] != -1)
+  for (level = 0; level <= distance; ++level)
+  {
+    if (level < numLevels)
     {
-      Vertex adjV = neighbors[j];
-
-      if (!isElementInSet(discoveredSet, adjV))
+      for (k = start; k < levelEnd[level]; ++k)
       {
-        if (!Enqueue(frontierQ, adjV)) { printf("Error!\n"); exit(-1); }
-        if (!AddToSet(discoveredSet, adjV)) { printf("Error!\n"); exit(-1); }
+        visited[i] = order[k];
+        ++i;
       }
 
-      ++j;
+      start = levelEnd[level];
     }
 
-    myfree(neighbors);
-
-  }//while
+    visited[i] = -1;  // marker:
+    ++i;
+  }
 
-   //
-   // done:
-   //
   visited[i] = -1;  // mark end of vertices with -1:
 
-  DeleteQueue(frontierQ);
-  DeleteSet(discoveredSet);
+  EndSearch(WS, W);
+
+  if (stats != NULL)
+  {
+    stats->VerticesDequeued = expanded;
+    stats->VerticesExpanded = expanded;
+    stats->EdgesScanned = scanned;
+    stats->Relaxations = tail - 1;
+    stats->PeakFrontier = peak;
+    EndSearchStats(stats);
+  }
 
   return visited;
 }
@@ -758,356 +1277,311 @@ Vertex *BFSd(Graph *G, Vertex v, int distance)
 // of a vertex are visited, they are done so in ascending
 // order.
 //
+// If stats is not NULL, the search's counters are stored there (see
+// SearchStats); a relaxation is a push.  W is the search workspace
+// (see workspace.h); pass NULL to use a temporary one.
+//
 // NOTE: returns NULL if v is not a valid vertex id.
 //
 // NOTE: it is the responsibility of the CALLER to free the 
 // returned array when they are done.
 //
-Vertex *DFS(Graph *G, Vertex v)
+Vertex *DFS(Graph *G, Vertex v, SearchStats *stats, SearchWorkspace *W)
 {
   if (v < 0 || v >= G->NumVertices)  // invalid vertex #:
     return NULL;
 
+  if (stats != NULL)
+    BeginSearchStats(stats);
+
+  SearchWorkspace *WS = StartSearch(W, G->NumVertices);
+  unsigned int     epoch = WS->Epoch;
+  unsigned int    *stamp = WS->Stamp;  // stamped => visited
+  Vertex          *order = WS->Order;  // visited list
+  Stack           *frontierStack = WS->S;
+  int              count = 0;
+  int              popped = 0;
+  long             scanned = 0;
+  int              peak = 1;
+
   //
   // Perform DFS, starting at given vertex v:
   //
-  int N = G->NumVertices + 1;
-
-  Stack *frontierStack = CreateStack(N);
-  Set   *visitedSet = CreateSet(N);
-  Queue *visitedQ = CreateQueue(N);
-
   if (!Push(frontierStack, v)) { printf("Error!\n"); exit(-1); }
 
   while (!isEmptyStack(frontierStack))
   {
     Vertex currentV = Pop(frontierStack);
+    ++popped;
 
     //
-    // visit:  add to visited list *if* not already there, since
-    // DFS may end up visiting vertices multiple times:
-    //
-    if (!isElementInQueue(visitedQ, currentV))
-    {
-      if (!Enqueue(visitedQ, currentV)) { printf("Error!\n"); exit(-1); }
-    }
-
-    //
-    // now push neighbors in reverse order so that we visit in 
-    // ascending order:
+    // visit:  add to visited list *if* not already visited, since
+    // DFS may pop the same vertex multiple times; then push
+    // neighbors in reverse order so that we visit in ascending
+    // order:
     //
-    if (!isElementInSet(visitedSet, currentV))
+    if (stamp[currentV] != epoch)
     {
-      if (!AddToSet(visitedSet, currentV)) { printf("Error!\n"); exit(-1); }
+      stamp[currentV] = epoch;
+      order[count] = currentV;
+      ++count;
 
-      Vertex *neighbors = Neighbors(G, currentV);
+      NeighborSpan neighbors = NeighborsOf(G, currentV);
+      scanned += neighbors.Count;
 
       //
       // Note: push them backwards onto stack so vertices are
       // on the stack in ascending order:
       //
-      int j = 0;  // index into array of neighbors:
-
-      while (neighbors[j] != -1)  // find the end
-        j++;
+      int j;  // index into span of neighbors:
 
-      j--;  // advance to last vertex in the visited array:
-
-      while (j >= 0)  // now push backwards:
+      for (j = neighbors.Count - 1; j >= 0; --j)  // push backwards:
       {
-        Vertex adjV = neighbors[j];
+        Vertex adjV = neighbors.Vertices[j];
 
         if (!Push(frontierStack, adjV)) { printf("Error!\n"); exit(-1); }
-
-        --j;
       }
 
-      myfree(neighbors);
+      if (frontierStack->NumElements > peak)
+        peak = frontierStack->NumElements;
     }
   }//while
 
   //
-  // done: our set of visited vertices is in visitedQ, so let's
-  // copy out of there into a dynamically-allocated array:
-  //
-
-  //
-  // allocate array of worst-case size: # of vertices + 1
+  // done: copy the visited vertices into a dynamically-allocated
+  // array, and mark the end with -1 (the stack is empty again, ready
+  // for the next search):
   //
   Vertex *visited;
 
-  visited = (Vertex *)mymalloc(N * sizeof(Vertex));
+  visited = (Vertex *)mymalloc((count + 1) * sizeof(Vertex));
   if (visited == NULL)
   {
     printf("\n**Error in DFS: malloc failed to allocate\n\n");
     exit(-1);
   }
 
-  // dequeue vertices into the visited array:
-  int i = 0;  // index into visited array:
+  memcpy(visited, order, count * sizeof(Vertex));
+  visited[count] = -1;
 
-  while (!isEmptyQueue(visitedQ))
+  EndSearch(WS, W);
+
+  if (stats != NULL)  // every pop but the first followed a push:
   {
-    visited[i] = Dequeue(visitedQ);
-    ++i;
+    stats->VerticesDequeued = popped;
+    stats->VerticesExpanded = count;
+    stats->EdgesScanned = scanned;
+    stats->Relaxations = popped - 1;
+    stats->PeakFrontier = peak;
+    EndSearchStats(stats);
   }
 
-  visited[i] = -1;  // mark end of vertices with -1:
-
-  //
-  // Done:
-  //
-  DeleteStack(frontierStack);
-  DeleteSet(visitedSet);
-  DeleteQueue(visitedQ);
-
   return visited;
 }
 
+
 //
-// getEdgeWeight:
-//
-// Returns the weight along edge src -> dest.  If there are
-// multiple edges, returns the minimum weight; if there is no
-// such edge, an error message is printed and the program is
-// exited.
+// _touch:
 //
-// NOTE: the error message and program exit occur since you 
-// should never call function unless the edge exists.
+// Marks v as touched by the current search of W, if it isn't already,
+// which puts it undiscovered (-1) on both sides of a bidirectional
+// search.
 //
-int getEdgeWeight(Graph *G, Vertex src, Vertex dest)
+static void _touch(SearchWorkspace *W, Vertex v)
 {
-  if (src < 0 || src >= G->NumVertices)  // invalid vertex #:
-  {
-    printf("\n**Error in getEdgeWeight: src vertex (%d) invalid.\n\n", src);
-    exit(-1);
-  }
-  if (dest < 0 || dest >= G->NumVertices)  // invalid vertex #:
+  if (W->Stamp[v] != W->Epoch)
   {
-    printf("\n**Error in getEdgeWeight: dest vertex (%d) invalid.\n\n", dest);
-    exit(-1);
-  }
-  //
-  // search src's edge list, note that multi-edges appear together:
-  //
-  Edge *cur = G->Vertices[src];
-  int   weight;
-  int   haveEdge = 0;  /*false*/
-  while (cur != NULL)
-  {
-    if (dest == cur->dest)  // candidate edge:
-    {
-      if (!haveEdge) // first edge:
-      {
-        haveEdge = 1;  /*true*/
-        weight = cur->weight;
-      }
-      else if (cur->weight < weight)  // multi-edge:
-      {
-        weight = cur->weight;  // smaller, so update:
-      }
-    }
-    else if (dest < cur->dest)  // out of order, end search:
-      break;
-    // next edge:
-    cur = cur->next;
-  }
-  // 
-  // did we find an edge?  make sure...
-  //
-  if (!haveEdge)
-  {
-    printf("\n**Error in getEdgeWeight: no edge found from %d to %d.\n\n", src, dest);
-    exit(-1);
+    W->Stamp[v] = W->Epoch;
+    W->Distance[v] = -1;
+    W->Distance2[v] = -1;
+    W->Predecessor[v] = -1;
+    W->Predecessor2[v] = -1;
   }
-  //
-  // success:
-  //
-  return weight;
 }
 
 //
-// Performs Dijkstra's shortest path algorithm to find the shortest path
-// from src to dest.  Returns a dynamically-allocated array of vertices
-// denoting this path; the array will start with src, contain 0 or more
-// vertices that lead to dest, followed by dest, and ending with -1.  
-// If there is no pat from src to dest, the array will contain only -1.
+// BidirectionalBFS:
+//
+// Finds a shortest path (fewest edges) from src to dest by growing
+// two breadth-first searches, one forward from src and one backward
+// from dest, until they meet in the middle.  Each step expands one
+// full level of whichever frontier is smaller.  Returns the path in
+// the same form as Dijkstra():  a dynamically-allocated array that
+// starts with src, contains 0 or more vertices that lead to dest,
+// followed by dest, and ends with -1.  If there is no path from src
+// to dest, the array will contain only -1.
+//
+// The backward search follows edges in reverse, which is only valid
+// if the graph is symmetric (see FreezeGraph); otherwise only the
+// forward frontier is grown, i.e. a plain BFS from src.
+//
+// If stats is not NULL, the search's counters are stored there (see
+// SearchStats), for both sides together.  W is the search workspace
+// (see workspace.h); pass NULL to use a temporary one.
 //
 // NOTE: returns NULL if src or dest are not valid vertex ids.
 //
-// NOTE: it is the responsibility of the CALLER to myfree the 
+// NOTE: it is the responsibility of the CALLER to free the 
 // returned array when they are done.
 //
-int PopMin(Queue *unvisitedQ, int distance[])
+Vertex *BidirectionalBFS(Graph *G, Vertex src, Vertex dest, SearchStats *stats, SearchWorkspace *W)
 {
-  int    N = unvisitedQ->NumElements;
-  Stack *S = CreateStack(N); 
-  assert(!isEmptyQueue(unvisitedQ));
-  //
-  // search for smallest vertex distance in the queue,
-  // saving other elements in a stack so we can put back
-  // later:
-  //
-  int minV = Dequeue(unvisitedQ);  // assume first vertex is the min:
-  while (!isEmptyQueue(unvisitedQ))  // look for smaller vertex:
-  {
-    int v = Dequeue(unvisitedQ);
-    if (distance[v] < distance[minV])
-    {
-      Push(S, minV);  // save so we can put back in queue:
-      minV = v;  // our new min:
-    }
-    else  // not smaller, so save to enqueue later:
-    {
-      Push(S, v);
-    }
-  }
-  //
-  // empty the stack back into the queue:
-  //
-  while (!isEmptyStack(S))
-  {
-    Enqueue(unvisitedQ, Pop(S));
-  }
-  // NOTE: at this point queue is now one smaller, with
-  // min element removed.  Let's confirm:
-  assert(unvisitedQ->NumElements == (N - 1));
-  //
-  // done:
-  // 
-  DeleteStack(S);
-  return minV;
-}
-
-Vertex *Dijkstra(Graph *G, Vertex src, Vertex dest)
-{
-  int  INF = INT_MAX;
   if (src < 0 || src >= G->NumVertices)  // invalid vertex #:
     return NULL;
   if (dest < 0 || dest >= G->NumVertices)  // invalid vertex #:
     return NULL;
+
+  int v;
+
+  if (stats != NULL)
+    BeginSearchStats(stats);
+
+  SearchWorkspace *WS = StartSearch(W, G->NumVertices);
+
   //
-  // allocate distances array:
-  //
-  int N = G->NumVertices;
-  int *distance = (int *)mymalloc(N * sizeof(int));
-  if (distance == NULL)
-  {
-    printf("\n**Error in Dijkstra: mymalloc failed to allocate\n\n");
-    exit(-1);
-  }
-  Vertex *predecessor = (Vertex *)mymalloc(N * sizeof(Vertex));
-  if (predecessor == NULL)
-  {
-    printf("\n**Error in Dijkstra: mymalloc failed to allocate\n\n");
-    exit(-1);
-  }
-  //
-  // for each vertex, add to Queue to be visited,
-  // initialize distance to Infinity, and set predecessor
-  // to -1:
-  //
-  Queue *unvisitedQ = CreateQueue(N);
-  int currentV;
-  for (currentV = 0; currentV < N; ++currentV)
-  {
-    Enqueue(unvisitedQ, currentV);
-    distance[currentV] = INF; 
-    predecessor[currentV] = -1;
-  }
+  // per side: distance from that side's root (-1 => not discovered),
+  // predecessor towards the root, and the vertices discovered so far
+  // in order, the unexpanded ones (order[head..tail-1]) being the
+  // frontier.  A vertex must be touched before these are read:
   //
-  // starting vertex has a distance of 0 from itself:
+  int    *distF = WS->Distance;
+  int    *distB = WS->Distance2;
+  Vertex *predF = WS->Predecessor;
+  Vertex *predB = WS->Predecessor2;
+  Vertex *orderF = WS->Order;
+  Vertex *orderB = WS->Order2;
+  int     headF = 0, tailF = 0;
+  int     headB = 0, tailB = 0;
+  long    scanned = 0;
+  int     peak = 2;
+
+  _touch(WS, src);
+  _touch(WS, dest);
+
+  distF[src] = 0;
+  distB[dest] = 0;
+  orderF[tailF++] = src;
+  orderB[tailB++] = dest;
+
   //
-  distance[src] = 0;
+  // grow the smaller frontier one level at a time; when a level
+  // discovers vertices already seen by the other side, the best
+  // such meeting point lies on a shortest path:
   //
-  // Now run Dijkstra's algorithm:
+  // NOTE: like Dijkstra, there is no path from a vertex to itself,
+  // nor between vertices in different components.
   //
-  while (!isEmptyQueue(unvisitedQ))
+  Vertex meet = -1;
+  int    best = INT_MAX;
+  int    reachable = SameComponent(G, src, dest);
+
+  while (reachable && src != dest && meet == -1 && headF < tailF && headB < tailB)
   {
-    //
-    // find the vertex with the smallest distance from
-    // the start, that's the vertex to explore next:
-    //
-    currentV = PopMin(unvisitedQ, distance);
-    // is there a path to the current vertex?  if not, 
-    // there's no point in looking at neighbors...
-    if (distance[currentV] == INF)
-      break;
-    //
-    // now see if we have found any shorter paths for minV's
-    // neighboring vertices:
-    //
-    Vertex *neighbors = Neighbors(G, currentV);
-    int i = 0;
-    while (neighbors[i] != -1)  // for each neighbor:
+    int     forward = (!G->Symmetric || tailF - headF <= tailB - headB);
+    Vertex *order = forward ? orderF : orderB;
+    int    *head = forward ? &headF : &headB;
+    int    *tail = forward ? &tailF : &tailB;
+    int    *dist = forward ? distF : distB;
+    int    *otherDist = forward ? distB : distF;
+    Vertex *pred = forward ? predF : predB;
+
+    int  end = *tail;  // expand exactly this level:
+
+    while (*head < end)
     {
-      int adjV = neighbors[i];
-      int edgeWeight = getEdgeWeight(G, currentV, adjV);
-      int altDistance = distance[currentV] + edgeWeight;
-      if (altDistance < distance[adjV])
+      Vertex currentV = order[*head];
+      ++*head;
+
+      NeighborSpan neighbors = NeighborsOf(G, currentV);
+      scanned += neighbors.Count;
+
+      int j;  // index into span of neighbors:
+      for (j = 0; j < neighbors.Count; ++j)
       {
-        distance[adjV] = altDistance;
-        predecessor[adjV] = currentV;
+        Vertex adjV = neighbors.Vertices[j];
+
+        _touch(WS, adjV);
+
+        if (dist[adjV] == -1)  // newly discovered:
+        {
+          dist[adjV] = dist[currentV] + 1;
+          pred[adjV] = currentV;
+          order[*tail] = adjV;
+          ++*tail;
+
+          if (otherDist[adjV] != -1 && dist[adjV] + otherDist[adjV] < best)
+          {
+            best = dist[adjV] + otherDist[adjV];
+            meet = adjV;
+          }
+        }
       }
-      ++i;
+
+      if ((tailF - headF) + (tailB - headB) > peak)
+        peak = (tailF - headF) + (tailB - headB);
     }
-    myfree(neighbors);
-  }
-  //
-  // Okay, algorithm has run to completion, and the path (if
-  // any) is stored backwards in predecessor array.  So let's 
-  // use a stack to reverse it:
-  //
-  Stack *S = CreateStack(N);
-  int v = dest;
-  while (predecessor[v] != -1)
-  {
-    Push(S, v);
-    v = predecessor[v];
   }
-  // loop stops when it gets to src, so push src to finish:
-  Push(S, src);
+
   //
-  // at this point we have the path on the stack, or if there's
-  // no path, just src is on the stack.  Allocated an array and
-  // fill with path, or if no path, just -1:
+  // build path:  src .. meet from predF (reversed), then meet .. dest
+  // from predB:
   //
-  Vertex  *path;
-  if (S->NumElements == 1) // just src on stack, no path:
+  Vertex *path;
+
+  if (meet == -1)  // no path:
   {
-    N = 1;  // just the -1:
-    path = (Vertex *)mymalloc(N * sizeof(Vertex));
+    path = (Vertex *)mymalloc(1 * sizeof(Vertex));
     if (path == NULL)
     {
-      printf("\n**Error in Dijkstra: mymalloc failed to allocate\n\n");
+      printf("\n**Error in BidirectionalBFS: malloc failed to allocate\n\n");
       exit(-1);
     }
-    path[0] = -1;  // no path from src to dest:
+
+    path[0] = -1;
   }
   else
   {
-    N = S->NumElements + 1;  // path + -1 at the end
-    path = (Vertex *)mymalloc(N * sizeof(Vertex));
+    path = (Vertex *)mymalloc((best + 2) * sizeof(Vertex));  // best edges + 1 vertices + -1
     if (path == NULL)
     {
-      printf("\n**Error in Dijkstra: mymalloc failed to allocate\n\n");
+      printf("\n**Error in BidirectionalBFS: malloc failed to allocate\n\n");
       exit(-1);
     }
-    // now empty the stack into the path array:
-    int i = 0;
-    while (!isEmptyStack(S))
+
+    int i = distF[meet];
+
+    for (v = meet; v != -1; v = predF[v])  // fill backwards from meet to src:
+    {
+      path[i] = v;
+      --i;
+    }
+
+    i = distF[meet] + 1;
+
+    for (v = predB[meet]; v != -1; v = predB[v])  // then forward to dest:
     {
-      path[i] = Pop(S);
+      path[i] = v;
       ++i;
     }
+
     path[i] = -1;  // need -1 terminator at the end:
+    assert(i == best + 1);
   }
+
   //
-  // done!
+  // done:
   //
-  DeleteStack(S);
-  DeleteQueue(unvisitedQ);
-  myfree(distance); 
-  myfree(predecessor);
+  EndSearch(WS, W);
+
+  if (stats != NULL)  // both roots were discovered up front:
+  {
+    stats->VerticesDequeued = headF + headB;
+    stats->VerticesExpanded = headF + headB;
+    stats->EdgesScanned = scanned;
+    stats->Relaxations = (tailF - 1) + (tailB - 1);
+    stats->PeakFrontier = peak;
+    EndSearchStats(stats);
+  }
+
   return path;
 }
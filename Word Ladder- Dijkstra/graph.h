@@ -13,27 +13,113 @@ typedef struct Edge
   struct Edge *next;
 } Edge;
 
+//
+// A graph is built with AddVertex (or AddVertices) and AddEdge, which
+// keep one linked list of edges per vertex; the Edge nodes come from
+// a pool owned by the graph (see mymem.h), and are released all at
+// once.  FreezeGraph then converts the lists into
+// compressed sparse row (CSR) form: the edges out of v are stored
+// contiguously in Dests[Offsets[v] .. Offsets[v+1]-1], in order by
+// destination, with matching Weights; multi-edges are merged into one
+// edge with the minimum weight.  Once frozen, no more vertices or
+// edges may be added.
+//
+// Vertex names live back to back in one append-only arena: the name
+// of v is the '\0'-terminated string at NameChars + NameOffsets[v],
+// and NameOffsets[NumVertices] is the # of chars in use.  The arena
+// may move as vertices are added, so a name pointer is only valid
+// until the next AddVertex.  Names are found via NamesIndex, a hash
+// table of vertex ids keyed by name (see nameindex.h).
+//
+// FreezeGraph also labels the connected components, ignoring edge
+// direction:  Component[v] is v's component id, 0..NumComponents-1,
+// numbered in order of their lowest vertex, and ComponentSizes[c] is
+// the # of vertices in component c.  Vertices in different
+// components have no path between them.
+//
+// A graph loaded by LoadGraphSnapshot is frozen from the start, and
+// its names, name index and CSR arrays point into the mapped
+// snapshot file.
+//
 typedef struct Graph
 {
-  Edge    **Vertices;
-  AVLNode *NamesTree;
-  char    **Names;
+  Edge    **Vertices;  // adjacency lists (build phase only)
+  struct MemPool *EdgePool;  // Edge nodes of the lists (build phase only)
+  NameIndex *NamesIndex;
+  char     *NameChars;   // name arena
+  int      *NameOffsets; // start of each name in arena, NumVertices+1
+  int       NameCharsCapacity;
+  int      *Offsets;   // CSR row offsets, NumVertices+1 (frozen only)
+  Vertex   *Dests;     // CSR edge destinations, NumEdges (frozen only)
+  int      *Weights;   // CSR edge weights, NumEdges (frozen only)
+  int       Frozen;
+  int       Symmetric; // every edge u->v has a reverse v->u (frozen only)
+  int      *Component; // component id of each vertex, NumVertices (frozen only)
+  int      *ComponentSizes;  // # of vertices in each component (frozen only)
+  int       NumComponents;
+  void     *Snapshot;  // mapped snapshot file, or NULL
+  long      SnapshotSize;
   int       NumVertices;
   int       NumEdges;
   int       Capacity;
 } Graph;
 
+//
+// NeighborSpan:
+//
+// A read-only view of v's neighbors in a frozen graph, borrowed from
+// the graph's CSR arrays:  Vertices[0..Count-1] in ascending order,
+// with the edge weights in Weights[0..Count-1].  Nothing is allocated,
+// so there is nothing to free.
+//
+typedef struct NeighborSpan
+{
+  Vertex  *Vertices;
+  int     *Weights;
+  int      Count;
+} NeighborSpan;
+
+//
+// SearchStats:
+//
+// Optional counters filled in by a search, to see where a query's
+// time goes and to compare searches on the same query; pass NULL if
+// not wanted.  A relaxation is a vertex being discovered, or (for
+// Dijkstra and A*) given a shorter distance; the frontier is the
+// search's queue or stack.  Allocations are the mymalloc calls made
+// by the search's thread, including for the returned array.
+//
+typedef struct SearchStats
+{
+  int        VerticesDequeued;  // taken off the frontier
+  int        VerticesExpanded;  // vertices whose edges were scanned
+  long       EdgesScanned;
+  long       Relaxations;
+  int        PeakFrontier;      // most vertices in the frontier at once
+  long       Allocations;
+  long long  Nanos;             // elapsed wall-clock time
+} SearchStats;
+
 Graph  *CreateGraph(int N);
 void    DeleteGraph(Graph *G);
 int     AddVertex(Graph *G, char *name);
+int     AddVertices(Graph *G, char *names, int n);
 int     Name2Vertex(Graph *G, char *Name);
 char   *Vertex2Name(Graph *G, Vertex v);
 int     AddEdge(Graph *G, Vertex src, Vertex dest, int weight);
+void    FreezeGraph(Graph *G);
+int     SameComponent(Graph *G, Vertex u, Vertex v);
 
 Vertex *Neighbors(Graph *G, Vertex v);
+NeighborSpan NeighborsOf(Graph *G, Vertex v);
 void    PrintGraph(Graph *G, char *title, int complete);
-Vertex *BFS(Graph *G, Vertex v);
-Vertex *BFSd(Graph *G, Vertex v, int distance);
-Vertex *DFS(Graph *G, Vertex v);
+Vertex *BFS(Graph *G, Vertex v, SearchStats *stats, SearchWorkspace *W);
+Vertex *BFSd(Graph *G, Vertex v, int distance, SearchStats *stats, SearchWorkspace *W);
+Vertex *DFS(Graph *G, Vertex v, SearchStats *stats, SearchWorkspace *W);
+Vertex *BidirectionalBFS(Graph *G, Vertex src, Vertex dest, SearchStats *stats, SearchWorkspace *W);
 int getEdgeWeight(Graph *G, Vertex src, Vertex dest);
-Vertex *Dijkstra(Graph *G, Vertex src, Vertex dest);
+Vertex *Dijkstra(Graph *G, Vertex src, Vertex dest, SearchStats *stats, SearchWorkspace *W);
+Vertex *AStar(Graph *G, Vertex src, Vertex dest, SearchStats *stats, SearchWorkspace *W);
+void    BeginSearchStats(SearchStats *stats);
+void    EndSearchStats(SearchStats *stats);
+void    PrintSearchStats(SearchStats *stats);
@@ -19,110 +19,21 @@
 #include <math.h>
 #include <assert.h>
 
-#include "avl.h"
+#include "nameindex.h"
+#include "workspace.h"
 #include "graph.h"
+#include "wordgraph.h"
+#include "snapshot.h"
+#include "batch.h"
+#include "server.h"
 #include "mymem.h"
 #include "timer.h"
 
 
-//
-// Read_and_AddWords:
-//
-Graph *Read_and_AddWords(char *filename)
-{
-  FILE  *input;
-  char   line[256];
-  int    linesize = sizeof(line) / sizeof(line[0]);
-
-  input = fopen(filename, "r");
-  if (input == NULL)
-  {
-    printf("**ERROR: '%s' not found\n\n", filename);
-    exit(-1);
-  }
-
-  //
-  // (1) input words and insert each word as a vertex:
-  //
-  printf(">>Building Graph from '%s'...\n", filename);
-
-  Graph *G = CreateGraph(256);  // 256 => initial size:
-
-  fgets(line, linesize, input);
-
-  while (!feof(input))
-  {
-    line[strcspn(line, "\r\n")] = '\0';  // strip EOL(s) char at end:
-
-    if (AddVertex(G, line) < 0)
-    {
-      printf("**Error: AddVertex failed?!\n\n");
-      exit(-1);
-    }
-
-    fgets(line, linesize, input);
-  }
-
-  //
-  // done:
-  //
-  fclose(input);
-
-  return G;
-}
-
-
-//
-// AddEdges:
-//
-void AddEdges(Graph *G)
-{
-  //
-  // (2) Now for each word, let's generate all possible
-  // words that differ by one letter, and add edges to/from
-  // these words in the graph:
-  //
-  int  v;
-
-  for (v = 0; v < G->NumVertices; ++v)
-  {
-    char *word = G->Names[v];
-
-    char *temp = (char *)mymalloc(((int)(strlen(word) + 1)) * sizeof(char));
-
-    int  i;
-    for (i = 0; i < (int)strlen(word); ++i)
-    {
-      strcpy(temp, word);
-
-      char  c = 'a';
-      while (c <= 'z')
-      {
-        temp[i] = c;  // change one letter:
-
-        int v2 = Name2Vertex(G, temp);
-        if (v2 >= 0 && v2 != v)  // dest exists, add edge:
-        {
-          if (!AddEdge(G, v, v2, 1))
-          {
-            printf("**Error: AddEdge failed?!\n\n");
-            exit(-1);
-          }
-        }//if
-
-        ++c;
-      }
-    }
-
-    myfree(temp);
-  }
-}
-
-
 //
 // PrintNeighborsAndBFS:
 //
-void PrintNeighborsAndBFS(Graph *G, int v)
+void PrintNeighborsAndBFS(Graph *G, int v, SearchWorkspace *W)
 {
   char line[256];
   int  linesize = sizeof(line) / sizeof(line[0]);
@@ -157,7 +68,7 @@ void PrintNeighborsAndBFS(Graph *G, int v)
   scanf("%d", &distance);
   fgets(line, linesize, stdin);  // discard rest of line:
 
-  V = BFSd(G, v, distance);
+  V = BFSd(G, v, distance, NULL, W);
 
   //
   // BFSd returns vertices separated by "markers" of -1
@@ -195,39 +106,220 @@ void PrintNeighborsAndBFS(Graph *G, int v)
 //
 // main:
 //
-int main()
+int main(int argc, char *argv[])
 {
   Graph *G;
+  SearchWorkspace *W;
   char  *filename = "merriam-webster.txt";
   char   line[256];
   int    linesize = sizeof(line) / sizeof(line[0]);
+  int    engine = EDGES_BY_BUCKETS;
+  int    numThreads = 1;
+  int    search = SEARCH_DIJKSTRA;
+  int    perfectHash = 0;  /*false*/
+  char  *saveSnapshot = NULL;
+  char  *loadSnapshot = NULL;
+  int    batch = 0;  /*false*/
+  char  *batchFile = NULL;
+  char  *serveAddress = NULL;
+  int    withStats = 0;  /*false*/
+  int    perf = 0;  /*false*/
+  int    arg;
+
+  //
+  // options:
+  //   --edges=probe      build edges with the original 26 x L lookups
+  //   --edges=buckets    build edges with wildcard buckets (default)
+  //   --threads=N        build edges, and answer --batch/--serve
+  //                      queries, using N threads (default 1)
+  //   --search=dijkstra  find ladders with Dijkstra() (default)
+  //   --search=astar     find ladders with AStar(), and report the
+  //                      # of vertices expanded vs. Dijkstra()
+  //   --search=bidir     find ladders with BidirectionalBFS()
+  //   --stats            report each search's counters (vertices
+  //                      dequeued and expanded, edges scanned, etc.;
+  //                      see SearchStats), after the ladder
+  //   --perf             also count CPU cycles, instructions, cache
+  //                      and branch misses in each timed phase, if
+  //                      the system allows (see timer.h)
+  //   --perfect-hash     once the graph is built, rebuild the name
+  //                      index as a minimal perfect hash
+  //   --save-snapshot F  after building the graph, save it to file F
+  //   --load-snapshot F  load the graph from snapshot file F instead
+  //                      of building it from the dictionary
+  //   --batch            answer "src dest" queries from stdin, one
+  //                      ladder per output line, without prompts
+  //   --batch=F          same, reading the queries from file F
+  //   --serve=A          serve queries on address A, a port # on
+  //                      127.0.0.1 or a Unix socket path, using
+  //                      --threads workers (see server.h)
+  //   <filename>         dictionary to read
+  //
+  for (arg = 1; arg < argc; ++arg)
+  {
+    if (strcmp(argv[arg], "--edges=probe") == 0)
+      engine = EDGES_BY_PROBING;
+    else if (strcmp(argv[arg], "--edges=buckets") == 0)
+      engine = EDGES_BY_BUCKETS;
+    else if (strncmp(argv[arg], "--threads=", 10) == 0 && atoi(argv[arg] + 10) > 0)
+      numThreads = atoi(argv[arg] + 10);
+    else if (strcmp(argv[arg], "--search=dijkstra") == 0)
+      search = SEARCH_DIJKSTRA;
+    else if (strcmp(argv[arg], "--search=bidir") == 0)
+      search = SEARCH_BIDIR;
+    else if (strcmp(argv[arg], "--search=astar") == 0)
+      search = SEARCH_ASTAR;
+    else if (strcmp(argv[arg], "--stats") == 0)
+      withStats = 1;  /*true*/
+    else if (strcmp(argv[arg], "--perf") == 0)
+      perf = 1;  /*true*/
+    else if (strcmp(argv[arg], "--perfect-hash") == 0)
+      perfectHash = 1;  /*true*/
+    else if (strcmp(argv[arg], "--save-snapshot") == 0 && arg + 1 < argc)
+      saveSnapshot = argv[++arg];
+    else if (strcmp(argv[arg], "--load-snapshot") == 0 && arg + 1 < argc)
+      loadSnapshot = argv[++arg];
+    else if (strcmp(argv[arg], "--batch") == 0)
+      batch = 1;  /*true*/
+    else if (strncmp(argv[arg], "--batch=", 8) == 0)
+    {
+      batch = 1;  /*true*/
+      batchFile = argv[arg] + 8;
+    }
+    else if (strncmp(argv[arg], "--serve=", 8) == 0 && argv[arg][8] != '\0')
+      serveAddress = argv[arg] + 8;
+    else if (argv[arg][0] != '-')
+      filename = argv[arg];
+    else
+    {
+      printf("**Error: unknown option '%s'\n\n", argv[arg]);
+      exit(-1);
+    }
+  }
+
+  //
+  // in batch mode, stdout carries only the answers:
+  //
+  if (!batch)
+    printf("** Starting Word Ladder App **\n\n");
 
-  printf("** Starting Word Ladder App **\n\n");
+  if (perf)  // before any threads; the summary says if none opened:
+    timer_enable_counters();
 
   //
   // (1) input words and insert each word as a vertex:
   //
   timer_start();
 
-  G = Read_and_AddWords(filename);
+  if (loadSnapshot != NULL)  // graph was saved earlier, just map it:
+  {
+    if (!batch)
+      printf(">>Loading Graph from '%s'...\n", loadSnapshot);
 
-  //
-  // (2) Now for each word, let's generate all possible
-  // words that differ by one letter, and add edges to/from
-  // these words in the graph:
-  //
-  AddEdges(G);
+    timer_begin("load snapshot");
+    G = LoadGraphSnapshot(loadSnapshot);
+    if (G == NULL)
+      exit(-1);
+    timer_end();
+  }
+  else
+  {
+    if (!batch)
+      printf(">>Building Graph from '%s'...\n", filename);
+
+    timer_begin("build graph");
+
+    timer_begin("read words");
+    G = Read_and_AddWords(filename);
+    timer_end();
+
+    //
+    // (2) Now for each word, let's generate all possible
+    // words that differ by one letter, and add edges to/from
+    // these words in the graph:
+    //
+    timer_begin("add edges");
+    AddEdges(G, engine, numThreads);
+    timer_end();
+
+    //
+    // the graph is complete, convert to read-only CSR form:
+    //
+    timer_begin("freeze");
+    FreezeGraph(G);
+    timer_end();
+
+    //
+    // the set of names is now fixed too:
+    //
+    if (perfectHash)
+    {
+      timer_begin("perfect hash");
+      if (!BuildPerfectNameIndex(G->NamesIndex, G->NameChars, G->NameOffsets))
+        printf("**Warning: unable to build perfect hash, using hash table\n");
+      timer_end();
+    }
+
+    timer_end();
+  }
+
+  if (saveSnapshot != NULL)
+  {
+    timer_begin("save snapshot");
+    if (!SaveGraphSnapshot(G, saveSnapshot))
+      exit(-1);
+    timer_end();
+
+    if (!batch)
+      printf(">>Saved Graph to '%s'\n", saveSnapshot);
+  }
+
+  if (batch)  // answer the queries, and we're done:
+  {
+    timer_begin("batch");
+    RunBatch(G, search, batchFile, numThreads, withStats);
+    timer_end();
+
+    DeleteGraph(G);
+
+    timer_summary(stderr);  // stdout is for the answers
+
+    return 0;
+  }
 
   //
   // (3) print some graph stats:
   //
+  timer_begin("print graph");
   PrintGraph(G, "Word Ladder", 0 /*false*/);
+  timer_end();
 
   timer_stop();
   timer_stats(">>Build time:    ");
 
   printf("\n");
 
+  if (serveAddress != NULL)  // serve queries until stopped, and we're done:
+  {
+    timer_begin("serve");
+    if (!RunServer(G, search, serveAddress, numThreads))
+      exit(-1);
+    timer_end();
+
+    DeleteGraph(G);
+
+    printf("\n** Done **\n");
+    timer_summary(stdout);
+    mymem_stats();
+
+    return 0;
+  }
+
+  //
+  // one workspace, reused by every search below:
+  //
+  W = CreateSearchWorkspace(G->NumVertices);
+
   //
   // (4) input words from the user and perform BFS:
   //
@@ -258,8 +350,10 @@ int main()
         printf("Word %d not found, please try again...\n", count++);
         else
         {
+          SearchStats stats;
+
           timer_start();
-          ladder = Dijkstra(G,v1,v2);
+          ladder = FindLadder(G,v1,v2,search,&stats,W);
           if(ladder[0] == -1)
             printf("** There is no word ladder from '%s' to '%s'. \n", Vertex2Name(G,v1), Vertex2Name(G,v2));
           else
@@ -272,6 +366,17 @@ int main()
             timer_stop();
             timer_stats("   Time:   ");
           }
+          if (search == SEARCH_ASTAR)  // compare with plain Dijkstra:
+          {
+            SearchStats dijkstraStats;
+            Vertex *check = Dijkstra(G,v1,v2,&dijkstraStats,W);
+
+            printf("   Expanded: %d vertices (Dijkstra: %d)\n", stats.VerticesExpanded, dijkstraStats.VerticesExpanded);
+            myfree(check);
+          }
+          if (withStats)
+            PrintSearchStats(&stats);
+          myfree(ladder);
         }
       }
     }
@@ -286,10 +391,11 @@ int main()
   //
   // done:
   //
+  DeleteSearchWorkspace(W);
   DeleteGraph(G);
-  myfree(ladder);
 
   printf("\n** Done **\n");
+  timer_summary(stdout);
   mymem_stats();
 
   printf("\n");
@@ -0,0 +1,395 @@
+/*microbench.c*/
+
+//
+// Micro-benchmarks for the ADTs:  times each operation of the queue,
+// stack, set, bitset, priority queue and AVL tree, at sizes up to
+// that of the full dictionary's graph, in the access patterns the
+// app uses them in:
+//
+//   queue    Enqueue/Dequeue in BFS order, from a small initial
+//            capacity; isElementInQueue lookups (a linear scan)
+//   stack    Push/Pop in DFS order, from a small initial capacity
+//   set      AddToSet in ascending, random and descending order (the
+//            latter two shift elements); isElementInSet lookups
+//   bitset   AddToBitset and isElementInBitset, for comparison with
+//            the set
+//   pqueue   PQInsert/PQPopMin with random priorities, and
+//            decrease-key
+//   avl      Insert in dictionary (sorted) and random order, with
+//            mymalloc'd and pooled nodes; Contains lookups
+//
+// Lookups hit half the time.  Output is one JSON object per line:
+// the ADT, operation, pattern, size n, # of ops timed, ns/op, and
+// mymalloc calls/op.  The same seed always gives the same inputs.
+//
+// Usage:  ./microbench [--seed=N] [n ...]
+//
+// with n = 1024, 16384 and 121778 (the full dictionary) by default;
+// at the largest size the set's quadratic inserts take most of the
+// run, some 10 seconds.
+//
+// Build:  make microbench
+//
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "queue.h"
+#include "stack.h"
+#include "set.h"
+#include "bitset.h"
+#include "pqueue.h"
+#include "avl.h"
+#include "mymem.h"
+#include "timer.h"
+
+#define MICRO_SEED      251
+#define MICRO_CAPACITY  8          // initial capacity, so growth is timed
+#define MICRO_SCANS     100000000  // element visits, for linear lookups
+
+static unsigned long long RandomState;
+
+static int _random(int n)  // xorshift64*, 0..n-1:
+{
+  RandomState ^= RandomState >> 12;
+  RandomState ^= RandomState << 25;
+  RandomState ^= RandomState >> 27;
+
+  return (int)(((RandomState * 2685821657736338717ULL) >> 33) % (unsigned long long)n);
+}
+
+//
+// _shuffled:
+//
+// Returns 0..n-1 in random order.
+//
+static int *_shuffled(int n)
+{
+  int *A = (int *)mymalloc((n + 1) * sizeof(int));
+  int  i;
+
+  for (i = 0; i < n; ++i)
+    A[i] = i;
+
+  for (i = n - 1; i > 0; --i)
+  {
+    int j = _random(i + 1);
+    int t = A[i];
+
+    A[i] = A[j];
+    A[j] = t;
+  }
+
+  return A;
+}
+
+//
+// _lookups:
+//
+// Returns m keys to look up in a structure holding 0..n-1; about
+// half of them are in it.
+//
+static int *_lookups(int n, int m)
+{
+  int *A = (int *)mymalloc((m + 1) * sizeof(int));
+  int  i;
+
+  for (i = 0; i < m; ++i)
+    A[i] = _random(2 * n);
+
+  return A;
+}
+
+//
+// _word:
+//
+// The i-th of the 5-letter words "aaaaa", "aaaab", ..., so words in
+// order of i are in dictionary order.
+//
+static AVLElementType _word(int i)
+{
+  AVLElementType  value;
+  int             k;
+
+  value.Vertex = i;
+
+  for (k = 4; k >= 0; --k)
+  {
+    value.Word[k] = (char)('a' + i % 26);
+    i /= 26;
+  }
+
+  value.Word[5] = '\0';
+
+  return value;
+}
+
+//
+// Measurement:  _begin() before the ops, _end() after, which prints
+// the result line.
+//
+static long MallocsBefore;
+
+static void _begin()
+{
+  MallocsBefore = mymem_malloc_count();
+  timer_start();
+}
+
+static void _end(char *adt, char *op, char *pattern, int n, long ops)
+{
+  timer_stop();
+
+  long mallocs = mymem_malloc_count() - MallocsBefore;
+
+  if (ops < 1)
+    ops = 1;
+
+  printf("{\"bench\":\"micro\",\"adt\":\"%s\",\"op\":\"%s\",\"pattern\":\"%s\","
+         "\"n\":%d,\"ops\":%ld,\"ns_per_op\":%.2f,\"allocs_per_op\":%.4f}\n",
+         adt, op, pattern, n, ops, timer_value() * 1e9 / ops, (double)mallocs / ops);
+  fflush(stdout);
+}
+
+
+// #####################################################
+//
+// Benchmarks, one per ADT:
+//
+
+static void _benchQueue(int n)
+{
+  int  i, hits = 0;
+
+  Queue *Q = CreateQueue(MICRO_CAPACITY);
+
+  _begin();
+  for (i = 0; i < n; ++i)  // like BFS:  every vertex in, then out:
+    Enqueue(Q, i);
+  while (!isEmptyQueue(Q))
+    Dequeue(Q);
+  _end("queue", "Enqueue+Dequeue", "bfs", n, 2L * n);
+
+  for (i = 0; i < n; ++i)
+    Enqueue(Q, i);
+
+  int  m = (MICRO_SCANS / n < 1) ? 1 : MICRO_SCANS / n;
+  int *keys = _lookups(n, m);
+
+  _begin();
+  for (i = 0; i < m; ++i)
+    hits += isElementInQueue(Q, keys[i]);
+  _end("queue", "isElementInQueue", "random", n, m);
+
+  assert(hits <= m);
+
+  myfree(keys);
+  DeleteQueue(Q);
+}
+
+static void _benchStack(int n)
+{
+  int  i;
+
+  Stack *S = CreateStack(MICRO_CAPACITY);
+
+  _begin();
+  for (i = 0; i < n; ++i)  // like DFS:  every vertex pushed, then popped:
+    Push(S, i);
+  while (!isEmptyStack(S))
+    Pop(S);
+  _end("stack", "Push+Pop", "dfs", n, 2L * n);
+
+  DeleteStack(S);
+}
+
+static void _benchSet(int n)
+{
+  int  i, hits = 0;
+  int *order = _shuffled(n);
+  Set *S;
+
+  S = CreateSet(MICRO_CAPACITY);
+  _begin();
+  for (i = 0; i < n; ++i)
+    AddToSet(S, i);
+  _end("set", "AddToSet", "ascending", n, n);
+  DeleteSet(S);
+
+  S = CreateSet(MICRO_CAPACITY);
+  _begin();
+  for (i = 0; i < n; ++i)
+    AddToSet(S, order[i]);
+  _end("set", "AddToSet", "random", n, n);
+
+  int *keys = _lookups(n, n);
+
+  _begin();
+  for (i = 0; i < n; ++i)
+    hits += (isElementInSet(S, keys[i]) != 0);
+  _end("set", "isElementInSet", "random", n, n);
+  DeleteSet(S);
+
+  S = CreateSet(MICRO_CAPACITY);
+  _begin();
+  for (i = n - 1; i >= 0; --i)
+    AddToSet(S, i);
+  _end("set", "AddToSet", "descending", n, n);
+  DeleteSet(S);
+
+  assert(hits <= n);
+
+  myfree(keys);
+  myfree(order);
+}
+
+static void _benchBitset(int n)
+{
+  int  i, hits = 0;
+  int *order = _shuffled(n);
+  int *keys = _lookups(n, n);
+
+  Bitset *B = CreateBitset(2 * n);  // lookups range over 0..2n-1
+
+  _begin();
+  for (i = 0; i < n; ++i)
+    AddToBitset(B, order[i]);
+  _end("bitset", "AddToBitset", "random", n, n);
+
+  _begin();
+  for (i = 0; i < n; ++i)
+    hits += isElementInBitset(B, keys[i]);
+  _end("bitset", "isElementInBitset", "random", n, n);
+
+  assert(hits <= n);
+
+  DeleteBitset(B);
+  myfree(keys);
+  myfree(order);
+}
+
+static void _benchPQueue(int n)
+{
+  int  i;
+  int *priorities = _lookups(n, n);
+
+  PQueue *PQ = CreatePQueue(n);
+
+  _begin();
+  for (i = 0; i < n; ++i)
+    PQInsert(PQ, i, priorities[i]);
+  while (!isEmptyPQueue(PQ))
+    PQPopMin(PQ);
+  _end("pqueue", "PQInsert+PQPopMin", "random", n, 2L * n);
+
+  for (i = 0; i < n; ++i)
+    PQInsert(PQ, i, 2 * n + priorities[i]);
+
+  _begin();
+  for (i = 0; i < n; ++i)  // decrease-key, as Dijkstra relaxes edges:
+    PQInsert(PQ, i, priorities[i]);
+  _end("pqueue", "PQInsert", "decrease-key", n, n);
+
+  DeletePQueue(PQ);
+  myfree(priorities);
+}
+
+static void _benchAVL(int n)
+{
+  int      i, hits = 0;
+  int     *order = _shuffled(n);
+  AVLNode *root;
+
+  root = CreateAVLTree();
+  _begin();
+  for (i = 0; i < n; ++i)  // as the dictionary is read:
+    root = Insert(root, _word(i), NULL);
+  _end("avl", "Insert", "sorted", n, n);
+  FreeAVLTree(root, NULL);
+
+  root = CreateAVLTree();
+  _begin();
+  for (i = 0; i < n; ++i)
+    root = Insert(root, _word(order[i]), NULL);
+  _end("avl", "Insert", "random", n, n);
+
+  int *keys = _lookups(n, n);
+
+  _begin();
+  for (i = 0; i < n; ++i)
+    hits += (Contains(root, _word(keys[i])) != NULL);
+  _end("avl", "Contains", "random", n, n);
+
+  _begin();
+  FreeAVLTree(root, NULL);
+  _end("avl", "FreeAVLTree", "random", n, n);
+
+  //
+  // again, with the nodes from a pool:
+  //
+  MemPool *pool = mypool_create(sizeof(AVLNode), 4096);
+
+  root = CreateAVLTree();
+  _begin();
+  for (i = 0; i < n; ++i)
+    root = Insert(root, _word(order[i]), pool);
+  _end("avl", "Insert", "random-pooled", n, n);
+
+  _begin();
+  mypool_delete(pool);
+  _end("avl", "mypool_delete", "random-pooled", n, n);
+
+  assert(hits <= n);
+
+  myfree(keys);
+  myfree(order);
+}
+
+
+int main(int argc, char *argv[])
+{
+  int   defaults[] = { 1024, 16384, 121778 };
+  int   sizes[64];
+  int   numSizes = 0;
+  unsigned long long seed = MICRO_SEED;
+  int   arg, s;
+
+  for (arg = 1; arg < argc; ++arg)
+  {
+    if (strncmp(argv[arg], "--seed=", 7) == 0)
+      seed = strtoull(argv[arg] + 7, NULL, 10);
+    else if (atoi(argv[arg]) > 0 && atoi(argv[arg]) <= 26 * 26 * 26 * 26 * 26 && numSizes < 64)
+      sizes[numSizes++] = atoi(argv[arg]);
+    else
+    {
+      printf("**Error: invalid argument '%s'\n", argv[arg]);
+      printf("usage: %s [--seed=N] [n ...], with 1 <= n <= %d\n", argv[0], 26 * 26 * 26 * 26 * 26);
+      return -1;
+    }
+  }
+
+  if (numSizes == 0)
+  {
+    for (s = 0; s < (int)(sizeof(defaults) / sizeof(defaults[0])); ++s)
+      sizes[numSizes++] = defaults[s];
+  }
+
+  for (s = 0; s < numSizes; ++s)
+  {
+    RandomState = (seed + 1) * 0x9E3779B97F4A7C15ULL + (unsigned long long)sizes[s];
+
+    _benchQueue(sizes[s]);
+    _benchStack(sizes[s]);
+    _benchSet(sizes[s]);
+    _benchBitset(sizes[s]);
+    _benchPQueue(sizes[s]);
+    _benchAVL(sizes[s]);
+  }
+
+  return 0;
+}
@@ -12,24 +12,162 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
 #include "mymem.h"
 
-static int g_mallocs = 0;
-static int g_mallocFailures = 0;
-static int g_frees = 0;
-static int g_freeErrors = 0;
+//
+// counters are atomic, so threads may allocate concurrently:
+//
+static atomic_int g_mallocs = 0;
+static atomic_int g_mallocFailures = 0;
+static atomic_int g_frees = 0;
+static atomic_int g_freeErrors = 0;
+
+static atomic_long g_liveBytes = 0;
+static atomic_long g_peakBytes = 0;
+
+static _Thread_local long myMallocs = 0;  // this thread's share of g_mallocs
+
+static atomic_long g_poolAllocs = 0;
+static atomic_long g_poolFrees = 0;
+
+//
+// size histogram:  g_sizes[k] counts mallocs of 2^(k-1)+1 .. 2^k
+// bytes (k = 0 => 0 or 1 byte):
+//
+#define MEM_SIZE_CLASSES  33
+
+static atomic_int g_sizes[MEM_SIZE_CLASSES];
+
+//
+// call sites:  a fixed hash table, keyed by file and line.  A slot is
+// claimed by moving its State from empty to claimed, and published
+// once File and Line are set; sites beyond the table's capacity are
+// all charged to the last slot, "(other)".
+//
+#define MEM_MAX_SITES  512
+
+#define MEM_SITE_EMPTY    0
+#define MEM_SITE_CLAIMED  1
+#define MEM_SITE_READY    2
+
+typedef struct MemSite
+{
+  atomic_int   State;
+  const char  *File;
+  int          Line;
+  atomic_long  Mallocs;
+  atomic_long  Bytes;      // total bytes allocated here
+  atomic_long  LiveBytes;  // bytes allocated here, not yet freed
+} MemSite;
 
-void *mymalloc(unsigned int size)
+static MemSite g_sites[MEM_MAX_SITES + 1];
+
+//
+// every block starts with a header recording its size and site, so
+// myfree can account for it; the header keeps the block aligned:
+//
+typedef union MemHeader
+{
+  struct
+  {
+    unsigned int  Size;
+    int           Site;
+  } Info;
+  max_align_t  Align;
+} MemHeader;
+
+
+//
+// _siteOf:
+//
+// Returns the index of the site for file:line, adding it if new.
+//
+static int _siteOf(const char *file, int line)
+{
+  unsigned int  h = 2166136261u;
+  const char   *p;
+  int           i, probes;
+
+  for (p = file; *p != '\0'; ++p)
+    h = (h ^ (unsigned char)*p) * 16777619u;
+  h = (h ^ (unsigned int)line) * 16777619u;
+
+  i = (int)(h % MEM_MAX_SITES);
+
+  for (probes = 0; probes < MEM_MAX_SITES; ++probes)
+  {
+    MemSite *S = &g_sites[i];
+    int      state = atomic_load(&S->State);
+
+    if (state == MEM_SITE_EMPTY)
+    {
+      if (atomic_compare_exchange_strong(&S->State, &state, MEM_SITE_CLAIMED))
+      {
+        S->File = file;
+        S->Line = line;
+        atomic_store(&S->State, MEM_SITE_READY);
+
+        return i;
+      }
+    }
+
+    while (state == MEM_SITE_CLAIMED)  // another thread is adding it:
+      state = atomic_load(&S->State);
+
+    if (S->Line == line && (S->File == file || strcmp(S->File, file) == 0))
+      return i;
+
+    i = (i + 1) % MEM_MAX_SITES;
+  }
+
+  return MEM_MAX_SITES;  // table is full, "(other)":
+}
+
+static int _sizeClass(unsigned int size)
+{
+  int  k = 0;
+
+  while (k < MEM_SIZE_CLASSES - 1 && (1u << k) < size)
+    ++k;
+
+  return k;
+}
+
+void *mymalloc_at(unsigned int size, const char *file, int line)
 {
   g_mallocs++;
+  myMallocs++;
 
-  void *ptr = malloc(size);
+  MemHeader *H = (MemHeader *)malloc(sizeof(MemHeader) + size);
 
-  if (ptr == NULL)
+  if (H == NULL)
+  {
     g_mallocFailures++;
+    return NULL;
+  }
+
+  int site = _siteOf(file, line);
+
+  H->Info.Size = size;
+  H->Info.Site = site;
 
-  return ptr;
+  g_sizes[_sizeClass(size)]++;
+  g_sites[site].Mallocs++;
+  g_sites[site].Bytes += size;
+  g_sites[site].LiveBytes += size;
+
+  long live = atomic_fetch_add(&g_liveBytes, (long)size) + (long)size;
+  long peak = atomic_load(&g_peakBytes);
+
+  while (live > peak && !atomic_compare_exchange_weak(&g_peakBytes, &peak, live))
+    ;  // peak was updated meanwhile, retry:
+
+  return H + 1;
 }
 
 void myfree(void *ptr)
@@ -37,13 +175,306 @@ void myfree(void *ptr)
   g_frees++;
 
   if (ptr == NULL)
+  {
     g_freeErrors++;
+    return;
+  }
+
+  MemHeader *H = (MemHeader *)ptr - 1;
+
+  g_liveBytes -= H->Info.Size;
+  g_sites[H->Info.Site].LiveBytes -= H->Info.Size;
+
+  free(H);
+}
+
+long mymem_malloc_count()
+{
+  return atomic_load(&g_mallocs);
+}
+
+long mymem_thread_malloc_count()
+{
+  return myMallocs;
+}
+
+long mymem_live_bytes()
+{
+  return atomic_load(&g_liveBytes);
+}
+
+long mymem_peak_bytes()
+{
+  return atomic_load(&g_peakBytes);
+}
+
+void mymem_reset_peak()
+{
+  atomic_store(&g_peakBytes, atomic_load(&g_liveBytes));
+}
+
+
+// #####################################################
+//
+// Pools:
+//
+// A pool's objects come from an arena, which hands out memory by
+// bumping a pointer through large chunks; nothing is freed until
+// the arena is deleted, which frees every chunk at once.
+//
+
+//
+// each arena chunk starts with a link to the previous chunk; the
+// header keeps the chunk's memory aligned:
+//
+typedef union MemChunk
+{
+  union MemChunk  *Next;
+  max_align_t      Align;
+} MemChunk;
+
+typedef struct MemArena
+{
+  MemChunk     *Chunks;     // most recent chunk first
+  char         *Free;       // next free byte in current chunk
+  char         *End;        // end of current chunk
+  unsigned int  ChunkSize;
+  const char   *File;       // site that created the arena
+  int           Line;
+} MemArena;
 
-  free(ptr);
+struct MemPool
+{
+  MemArena     *Arena;
+  void         *FreeList;   // objects returned by mypool_free
+  unsigned int  ObjectSize;
+};
+
+//
+// _arenaCreate:
+//
+// Creates an empty arena that allocates memory in chunks of at least
+// chunkSize bytes.
+//
+static MemArena *_arenaCreate(unsigned int chunkSize, const char *file, int line)
+{
+  MemArena *A = (MemArena *)mymalloc_at(sizeof(MemArena), file, line);
+  if (A == NULL)
+  {
+    printf("\n**Error in mypool_create: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  A->Chunks = NULL;
+  A->Free = NULL;
+  A->End = NULL;
+  A->ChunkSize = (chunkSize < 1) ? 1 : chunkSize;
+  A->File = file;
+  A->Line = line;
+
+  return A;
+}
+
+//
+// _arenaAlloc:
+//
+// Returns size bytes from the arena, aligned to align (a power of 2,
+// no larger than a chunk's alignment); starts a new chunk if the
+// current one is too full.
+//
+static void *_arenaAlloc(MemArena *A, unsigned int size, unsigned int align)
+{
+  uintptr_t  at = ((uintptr_t)A->Free + (align - 1)) & ~(uintptr_t)(align - 1);
+
+  if (A->Free == NULL || at + size > (uintptr_t)A->End)
+  {
+    unsigned int chunkSize = (size > A->ChunkSize) ? size : A->ChunkSize;
+
+    MemChunk *C = (MemChunk *)mymalloc_at(sizeof(MemChunk) + chunkSize, A->File, A->Line);
+    if (C == NULL)
+    {
+      printf("\n**Error in mypool_alloc: malloc failed to allocate\n\n");
+      exit(-1);
+    }
+
+    C->Next = A->Chunks;
+    A->Chunks = C;
+    A->Free = (char *)(C + 1);
+    A->End = A->Free + chunkSize;
+
+    at = (uintptr_t)A->Free;
+  }
+
+  A->Free = (char *)(at + size);
+
+  return (void *)at;
+}
+
+//
+// _arenaDelete:
+//
+// Frees the arena and all the memory it has handed out.
+//
+static void _arenaDelete(MemArena *A)
+{
+  MemChunk *cur = A->Chunks;
+
+  while (cur != NULL)
+  {
+    MemChunk *temp = cur;
+    cur = cur->Next;
+
+    myfree(temp);
+  }
+
+  myfree(A);
+}
+
+//
+// mypool_create_at:
+//
+// Creates an empty pool of objects of the given size, allocated
+// objectsPerChunk at a time.
+//
+MemPool *mypool_create_at(unsigned int objectSize, unsigned int objectsPerChunk,
+                          const char *file, int line)
+{
+  MemPool *P = (MemPool *)mymalloc_at(sizeof(MemPool), file, line);
+  if (P == NULL)
+  {
+    printf("\n**Error in mypool_create: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  //
+  // a free object holds the free list link, and the size is kept a
+  // multiple of the link's size so every object stays aligned (an
+  // object's alignment always divides its size):
+  //
+  if (objectSize < sizeof(void *))
+    objectSize = sizeof(void *);
+  objectSize = (objectSize + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+
+  if (objectsPerChunk < 1)
+    objectsPerChunk = 1;
+
+  P->Arena = _arenaCreate(objectSize * objectsPerChunk, file, line);
+  P->FreeList = NULL;
+  P->ObjectSize = objectSize;
+
+  return P;
 }
 
+//
+// mypool_alloc:
+//
+// Returns an object from the pool, reusing a freed one if possible.
+//
+void *mypool_alloc(MemPool *P)
+{
+  g_poolAllocs++;
+
+  if (P->FreeList != NULL)
+  {
+    void *obj = P->FreeList;
+
+    P->FreeList = *(void **)obj;
+    return obj;
+  }
+
+  return _arenaAlloc(P->Arena, P->ObjectSize, sizeof(void *));
+}
+
+//
+// mypool_free:
+//
+// Returns an object to the pool for reuse.
+//
+void mypool_free(MemPool *P, void *ptr)
+{
+  g_poolFrees++;
+
+  *(void **)ptr = P->FreeList;
+  P->FreeList = ptr;
+}
+
+//
+// mypool_delete:
+//
+// Frees the pool and every object in it, whether or not the objects
+// were returned with mypool_free.
+//
+void mypool_delete(MemPool *P)
+{
+  _arenaDelete(P->Arena);
+  myfree(P);
+}
+
+
 void mymem_stats()
 {
+  int  i, k;
+
   printf("** Memory stats: malloc (%d, %d), free (%d, %d)\n",
-    g_mallocs, g_mallocFailures, g_frees, g_freeErrors);
+    atomic_load(&g_mallocs), atomic_load(&g_mallocFailures),
+    atomic_load(&g_frees), atomic_load(&g_freeErrors));
+
+  printf("** Memory bytes: %ld live, %ld peak\n",
+    atomic_load(&g_liveBytes), atomic_load(&g_peakBytes));
+
+  printf("** Memory pools: %ld allocs, %ld frees\n",
+    atomic_load(&g_poolAllocs), atomic_load(&g_poolFrees));
+
+  printf("** Memory sizes (up to N bytes: # of mallocs):\n  ");
+  for (k = 0; k < MEM_SIZE_CLASSES; ++k)
+  {
+    if (atomic_load(&g_sizes[k]) > 0)
+      printf(" %lu: %d", 1ul << k, atomic_load(&g_sizes[k]));
+  }
+  printf("\n");
+
+  //
+  // sites, busiest first:  a simple selection of the top few:
+  //
+  int  top[10];
+  int  numTop = 0;
+
+  for (numTop = 0; numTop < 10; ++numTop)
+  {
+    int best = -1;
+
+    for (i = 0; i <= MEM_MAX_SITES; ++i)
+    {
+      int taken = 0;  /*false*/
+
+      for (k = 0; k < numTop; ++k)
+        taken = taken || (top[k] == i);
+
+      if (!taken && atomic_load(&g_sites[i].Mallocs) > 0 &&
+          (best < 0 || atomic_load(&g_sites[i].Mallocs) > atomic_load(&g_sites[best].Mallocs)))
+        best = i;
+    }
+
+    if (best < 0)
+      break;
+
+    top[numTop] = best;
+  }
+
+  printf("** Memory sites (top %d by # of mallocs):\n", numTop);
+  printf("   %-24s %10s %14s %12s\n", "site", "mallocs", "bytes", "live bytes");
+
+  for (k = 0; k < numTop; ++k)
+  {
+    MemSite *S = &g_sites[top[k]];
+    char     name[64];
+
+    if (top[k] == MEM_MAX_SITES)
+      strcpy(name, "(other)");
+    else
+      snprintf(name, sizeof(name), "%s:%d", S->File, S->Line);
+
+    printf("   %-24s %10ld %14ld %12ld\n", name,
+      atomic_load(&S->Mallocs), atomic_load(&S->Bytes), atomic_load(&S->LiveBytes));
+  }
 }
@@ -9,7 +9,39 @@
 // CS251, Fall 2016
 // HW #9
 //
+// mymalloc is a macro, so that each allocation is charged to the
+// file and line that made it; mymem_stats reports live and peak
+// bytes, a histogram of allocation sizes, and the busiest sites.
+//
 
-void *mymalloc(unsigned int size);
+void *mymalloc_at(unsigned int size, const char *file, int line);
 void  myfree(void *ptr);
 void  mymem_stats();
+
+long  mymem_malloc_count();  // # of mymalloc calls so far
+long  mymem_thread_malloc_count();  // same, by the calling thread
+long  mymem_live_bytes();
+long  mymem_peak_bytes();
+void  mymem_reset_peak();  // peak := live, to measure a phase's peak
+
+#define mymalloc(size)  mymalloc_at((size), __FILE__, __LINE__)
+
+//
+// Pools, for structures built from many small objects of one size
+// that are all released together.  A pool hands out objects by
+// bumping a pointer through large chunks, and keeps a free list, so
+// objects may also be returned one at a time and reused; deleting
+// the pool frees every chunk at once.  The chunks are allocated with
+// mymalloc, and charged to the site that created the pool.  A pool
+// is not thread-safe; each is meant to be owned by one structure.
+//
+typedef struct MemPool   MemPool;
+
+MemPool  *mypool_create_at(unsigned int objectSize, unsigned int objectsPerChunk,
+                           const char *file, int line);
+void     *mypool_alloc(MemPool *P);
+void      mypool_free(MemPool *P, void *ptr);
+void      mypool_delete(MemPool *P);
+
+#define mypool_create(objectSize, objectsPerChunk)  \
+  mypool_create_at((objectSize), (objectsPerChunk), __FILE__, __LINE__)
@@ -0,0 +1,524 @@
+/*nameindex.c*/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "nameindex.h"
+#include "mymem.h"
+
+
+// #####################################################
+//
+// Name index:
+//
+
+//
+// NameHash:
+//
+// FNV-1a hash of the given name.
+//
+unsigned int NameHash(char *name)
+{
+  unsigned int h = 2166136261u;
+
+  for (; *name != '\0'; ++name)
+  {
+    h ^= (unsigned char)*name;
+    h *= 16777619u;
+  }
+
+  return h;
+}
+
+//
+// _seededHash:
+//
+// Hash of name for perfect-hash displacement d; different values of
+// d give (roughly) independent hashes of the same name.
+//
+static unsigned int _seededHash(char *name, int d)
+{
+  unsigned int h = 2166136261u ^ ((unsigned int)d * 0x9E3779B9u);
+
+  for (; *name != '\0'; ++name)
+  {
+    h ^= (unsigned char)*name;
+    h *= 16777619u;
+  }
+
+  h ^= h >> 16;  // final mix, since we use the low bits:
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+
+  return h;
+}
+
+//
+// _allocSlots:
+//
+// Allocates an empty hash table of the given size.
+//
+static void _allocSlots(NameIndex *I, int numSlots)
+{
+  int  i;
+
+  I->Slots = (int *)mymalloc(numSlots * sizeof(int));
+  I->Hashes = (unsigned int *)mymalloc(numSlots * sizeof(unsigned int));
+  if (I->Slots == NULL || I->Hashes == NULL)
+  {
+    printf("\n**Error in NameIndex: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  for (i = 0; i < numSlots; ++i)
+    I->Slots[i] = -1;
+
+  I->NumSlots = numSlots;
+}
+
+//
+// CreateNameIndex:
+//
+// Creates an empty name index with room for about N names; the
+// index grows as needed.
+//
+NameIndex *CreateNameIndex(int N)
+{
+  NameIndex *I;
+  int        numSlots = 16;
+
+  if (N < 1)
+  {
+    printf("\n**Error in CreateNameIndex invalid parameter N (%d)\n\n", N);
+    return NULL;
+  }
+
+  I = (NameIndex *)mymalloc(sizeof(NameIndex));
+  if (I == NULL)
+  {
+    printf("\n**Error in CreateNameIndex: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  while (numSlots < 2 * N)  // at most half full:
+    numSlots *= 2;
+
+  _allocSlots(I, numSlots);
+
+  I->NumElements = 0;
+  I->Displace = NULL;
+  I->Perfect = NULL;
+  I->NumBuckets = 0;
+
+  return I;
+}
+
+//
+// DeleteNameIndex:
+//
+// Frees the memory associated with this index.
+//
+void DeleteNameIndex(NameIndex *I)
+{
+  if (I->Slots != NULL)  // NULL once perfect hash is built:
+  {
+    myfree(I->Slots);
+    myfree(I->Hashes);
+  }
+
+  if (I->Displace != NULL)  // NULL unless perfect hash is built:
+  {
+    myfree(I->Displace);
+    myfree(I->Perfect);
+  }
+
+  myfree(I);
+}
+
+//
+// _grow:
+//
+// Doubles the size of the hash table; entries are re-placed using
+// their stored hashes, so no names are needed.
+//
+static void _grow(NameIndex *I)
+{
+  int          *oldSlots = I->Slots;
+  unsigned int *oldHashes = I->Hashes;
+  int           oldN = I->NumSlots;
+  int           i;
+
+  _allocSlots(I, 2 * oldN);
+
+  unsigned int mask = (unsigned int)(I->NumSlots - 1);
+
+  for (i = 0; i < oldN; ++i)
+  {
+    if (oldSlots[i] == -1)
+      continue;
+
+    unsigned int slot = oldHashes[i] & mask;
+
+    while (I->Slots[slot] != -1)
+      slot = (slot + 1) & mask;
+
+    I->Slots[slot] = oldSlots[i];
+    I->Hashes[slot] = oldHashes[i];
+  }
+
+  myfree(oldSlots);
+  myfree(oldHashes);
+}
+
+//
+// NameIndexInsert:
+//
+// Adds vertex v, whose name is NameChars + NameOffsets[v], to the
+// index.  If another vertex with the same name is already in the
+// index, the index is unchanged and that vertex is returned;
+// otherwise v is returned.
+// Returns -1 if the index is read-only (perfect hash built).
+//
+int NameIndexInsert(NameIndex *I, char *NameChars, int *NameOffsets, int v)
+{
+  char *name = NameChars + NameOffsets[v];
+
+  if (I->Perfect != NULL)  // read-only:
+    return -1;
+
+  if (2 * (I->NumElements + 1) > I->NumSlots)
+    _grow(I);
+
+  unsigned int h = NameHash(name);
+  unsigned int mask = (unsigned int)(I->NumSlots - 1);
+  unsigned int slot = h & mask;
+
+  while (I->Slots[slot] != -1)
+  {
+    if (I->Hashes[slot] == h && strcmp(NameChars + NameOffsets[I->Slots[slot]], name) == 0)
+      return I->Slots[slot];  // already present:
+
+    slot = (slot + 1) & mask;
+  }
+
+  I->Slots[slot] = v;
+  I->Hashes[slot] = h;
+  I->NumElements++;
+
+  return v;
+}
+
+//
+// NameIndexInsertRange:
+//
+// Adds vertices first..first+n-1 to the index, with the same result
+// as NameIndexInsert'ing them one by one.  If the index is empty and
+// the names are in strictly ascending order --- by strcmp, or by
+// length and then strcmp, as the bundled dictionaries are --- they
+// are all distinct, so the table is sized once for all of them and
+// each id goes in the first free slot from its home, with no name
+// comparisons; checking the order is one pass over the names.  Any
+// other input is inserted one name at a time, so duplicates are
+// found as usual.  Returns false (0) if the index is read-only
+// (perfect hash built), true (non-zero) otherwise.
+//
+int NameIndexInsertRange(NameIndex *I, char *NameChars, int *NameOffsets, int first, int n)
+{
+  int  ascending = 1;  /*true*/
+  int  byLength = 1;   /*true*/
+  int  v;
+
+  if (I->Perfect != NULL)  // read-only:
+    return 0;  /*false*/
+
+  for (v = first + 1; v < first + n && (ascending || byLength); ++v)
+  {
+    int  cmp = strcmp(NameChars + NameOffsets[v - 1], NameChars + NameOffsets[v]);
+    int  prevLen = NameOffsets[v] - NameOffsets[v - 1];
+    int  len = NameOffsets[v + 1] - NameOffsets[v];
+
+    if (cmp >= 0)
+      ascending = 0;  /*false*/
+    if (prevLen > len || (prevLen == len && cmp >= 0))
+      byLength = 0;  /*false*/
+  }
+
+  if (I->NumElements > 0 || (!ascending && !byLength))  // one at a time:
+  {
+    for (v = first; v < first + n; ++v)
+      NameIndexInsert(I, NameChars, NameOffsets, v);
+
+    return 1;  /*true*/
+  }
+
+  //
+  // distinct names into an empty table:  size it once, at most half
+  // full, then place each name without comparing:
+  //
+  int  numSlots = I->NumSlots;
+
+  while (2 * n > numSlots)
+    numSlots *= 2;
+
+  if (numSlots != I->NumSlots)
+  {
+    myfree(I->Slots);
+    myfree(I->Hashes);
+    _allocSlots(I, numSlots);
+  }
+
+  unsigned int mask = (unsigned int)(I->NumSlots - 1);
+
+  for (v = first; v < first + n; ++v)
+  {
+    unsigned int h = NameHash(NameChars + NameOffsets[v]);
+    unsigned int slot = h & mask;
+
+    while (I->Slots[slot] != -1)
+      slot = (slot + 1) & mask;
+
+    I->Slots[slot] = v;
+    I->Hashes[slot] = h;
+  }
+
+  I->NumElements = n;
+
+  return 1;  /*true*/
+}
+
+//
+// NameIndexLookup:
+//
+// Returns the vertex with the given name, or -1 if not found.
+//
+int NameIndexLookup(NameIndex *I, char *NameChars, int *NameOffsets, char *name)
+{
+  if (I->Perfect != NULL)  // perfect hash:  one candidate slot
+  {
+    if (I->NumElements == 0)
+      return -1;
+
+    int d = I->Displace[NameHash(name) % (unsigned int)I->NumBuckets];
+    int slot;
+
+    if (d < 0)  // bucket holds a single name, stored directly:
+      slot = -d - 1;
+    else
+      slot = (int)(_seededHash(name, d) % (unsigned int)I->NumElements);
+
+    int v = I->Perfect[slot];
+
+    if (strcmp(NameChars + NameOffsets[v], name) == 0)
+      return v;
+
+    return -1;
+  }
+
+  //
+  // open addressing:  probe until found or empty slot
+  //
+  unsigned int h = NameHash(name);
+  unsigned int mask = (unsigned int)(I->NumSlots - 1);
+  unsigned int slot = h & mask;
+
+  while (I->Slots[slot] != -1)
+  {
+    if (I->Hashes[slot] == h && strcmp(NameChars + NameOffsets[I->Slots[slot]], name) == 0)
+      return I->Slots[slot];
+
+    slot = (slot + 1) & mask;
+  }
+
+  return -1;
+}
+
+//
+// BuildPerfectNameIndex:
+//
+// Rebuilds the index as a minimal perfect hash ("hash and displace"):
+// names are grouped into buckets by NameHash(); then, largest bucket
+// first, each bucket searches for a displacement d such that
+// _seededHash(name, d) sends all its names to free slots.  Buckets
+// with a single name just take the next free slot.  The open-
+// addressing table is freed, and the index becomes read-only.
+//
+// Returns true (non-zero) if successful, false (0) if no perfect
+// hash was found, in which case the index is unchanged.
+//
+int BuildPerfectNameIndex(NameIndex *I, char *NameChars, int *NameOffsets)
+{
+  int  n = I->NumElements;
+  int  numBuckets = (n / 2) + 1;  // about 2 names per bucket:
+  int  i, b;
+
+  if (I->Perfect != NULL)  // already built:
+    return 1;
+
+  int  *bucketStart = (int *)mymalloc((numBuckets + 1) * sizeof(int));
+  int  *members = (int *)mymalloc((n + 1) * sizeof(int));
+  int  *order = (int *)mymalloc((numBuckets + 1) * sizeof(int));
+  int  *displace = (int *)mymalloc(numBuckets * sizeof(int));
+  int  *perfect = (int *)mymalloc((n + 1) * sizeof(int));
+  int  *trial = (int *)mymalloc((n + 1) * sizeof(int));
+  if (bucketStart == NULL || members == NULL || order == NULL ||
+      displace == NULL || perfect == NULL || trial == NULL)
+  {
+    printf("\n**Error in BuildPerfectNameIndex: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  //
+  // (1) group names into buckets --- counting sort by bucket:
+  //
+  for (b = 0; b <= numBuckets; ++b)
+    bucketStart[b] = 0;
+
+  for (i = 0; i < I->NumSlots; ++i)
+  {
+    if (I->Slots[i] != -1)
+      bucketStart[(I->Hashes[i] % (unsigned int)numBuckets) + 1]++;
+  }
+
+  int maxSize = 0;
+
+  for (b = 0; b < numBuckets; ++b)
+  {
+    if (bucketStart[b + 1] > maxSize)
+      maxSize = bucketStart[b + 1];
+
+    bucketStart[b + 1] += bucketStart[b];
+  }
+
+  for (b = 0; b < numBuckets; ++b)  // use order[] as fill cursor for now:
+    order[b] = bucketStart[b];
+
+  for (i = 0; i < I->NumSlots; ++i)
+  {
+    if (I->Slots[i] != -1)
+    {
+      b = (int)(I->Hashes[i] % (unsigned int)numBuckets);
+      members[order[b]] = I->Slots[i];
+      order[b]++;
+    }
+  }
+
+  //
+  // (2) order buckets largest first --- counting sort by size:
+  //
+  int  k = 0;
+  int  size;
+
+  for (size = maxSize; size >= 0; --size)
+  {
+    for (b = 0; b < numBuckets; ++b)
+    {
+      if (bucketStart[b + 1] - bucketStart[b] == size)
+      {
+        order[k] = b;
+        ++k;
+      }
+    }
+  }
+
+  //
+  // (3) place buckets:  perfect[slot] == -1 => slot is free
+  //
+  for (i = 0; i < n; ++i)
+    perfect[i] = -1;
+
+  int  nextFree = 0;  // for single-name buckets:
+  int  success = 1;   /*true*/
+
+  for (k = 0; k < numBuckets && success; ++k)
+  {
+    b = order[k];
+    size = bucketStart[b + 1] - bucketStart[b];
+
+    if (size == 0)  // empty bucket, any displacement will do:
+    {
+      displace[b] = 0;
+    }
+    else if (size == 1)  // store directly in next free slot:
+    {
+      while (perfect[nextFree] != -1)
+        ++nextFree;
+
+      perfect[nextFree] = members[bucketStart[b]];
+      displace[b] = -nextFree - 1;
+    }
+    else  // search for a displacement that places every name:
+    {
+      int d;
+
+      for (d = 0; d < (1 << 20); ++d)
+      {
+        int j, placed = 0;
+
+        for (j = 0; j < size; ++j, ++placed)
+        {
+          int v = members[bucketStart[b] + j];
+          int slot = (int)(_seededHash(NameChars + NameOffsets[v], d) % (unsigned int)n);
+          int m;
+
+          if (perfect[slot] != -1)  // taken:
+            break;
+
+          for (m = 0; m < j; ++m)  // collides within bucket?
+            if (trial[m] == slot)
+              break;
+          if (m < j)
+            break;
+
+          trial[j] = slot;
+        }
+
+        if (placed == size)  // found one:
+          break;
+      }
+
+      if (d == (1 << 20))  // give up:
+      {
+        success = 0;  /*false*/
+        break;
+      }
+
+      int j;
+      for (j = 0; j < size; ++j)
+        perfect[trial[j]] = members[bucketStart[b] + j];
+
+      displace[b] = d;
+    }
+  }
+
+  myfree(bucketStart);
+  myfree(members);
+  myfree(order);
+  myfree(trial);
+
+  if (!success)
+  {
+    myfree(displace);
+    myfree(perfect);
+    return 0;  /*false*/
+  }
+
+  //
+  // switch over to perfect hash:
+  //
+  myfree(I->Slots);
+  myfree(I->Hashes);
+  I->Slots = NULL;
+  I->Hashes = NULL;
+  I->NumSlots = 0;
+
+  I->Displace = displace;
+  I->Perfect = perfect;
+  I->NumBuckets = numBuckets;
+
+  return 1;  /*true*/
+}
@@ -0,0 +1,35 @@
+/*nameindex.h*/
+
+//
+// Name index:
+//
+// Maps vertex names to vertex ids.  The index stores only vertex ids
+// (plus each name's hash); the names themselves stay in the graph's
+// name arena, which is passed to each call:  the name of vertex v is
+// at NameChars + NameOffsets[v].
+//
+// The index starts as an open-addressing hash table with linear
+// probing, kept at most half full.  Once all names are in, it can
+// be rebuilt as a minimal perfect hash:  every name maps to its own
+// slot in a table of exactly NumElements entries, so a lookup is
+// two hash computations and a single strcmp.  After that the index
+// is read-only.
+//
+typedef struct NameIndex
+{
+  int          *Slots;       // hash table of vertex ids, -1 => empty
+  unsigned int *Hashes;      // NameHash() of the name in each slot
+  int           NumSlots;    // size of hash table, a power of 2
+  int           NumElements; // # of names in the index
+  int          *Displace;    // perfect hash: per-bucket displacement (NULL => not built)
+  int          *Perfect;     // perfect hash: vertex id in each of NumElements slots
+  int           NumBuckets;  // perfect hash: # of buckets
+} NameIndex;
+
+NameIndex   *CreateNameIndex(int N);
+void         DeleteNameIndex(NameIndex *I);
+unsigned int NameHash(char *name);
+int          NameIndexInsert(NameIndex *I, char *NameChars, int *NameOffsets, int v);
+int          NameIndexInsertRange(NameIndex *I, char *NameChars, int *NameOffsets, int first, int n);
+int          NameIndexLookup(NameIndex *I, char *NameChars, int *NameOffsets, char *name);
+int          BuildPerfectNameIndex(NameIndex *I, char *NameChars, int *NameOffsets);
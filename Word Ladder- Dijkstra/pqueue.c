@@ -0,0 +1,250 @@
+/*pqueue.c*/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "pqueue.h"
+#include "mymem.h"
+
+
+// #####################################################
+//
+// Priority Queue:
+//
+
+//
+// CreatePQueue:
+//
+// Creates an empty priority queue for elements in the range
+// 0..N-1; each element can be in the queue at most once.
+//
+PQueue *CreatePQueue(int N)
+{
+  PQueue *PQ;
+  int     i;
+
+  if (N < 1)
+  {
+    printf("\n**Error in CreatePQueue invalid parameter N (%d)\n\n", N);
+    return NULL;
+  }
+
+  //
+  // allocate header and arrays:
+  //
+  PQ = (PQueue *)mymalloc(sizeof(PQueue));
+  if (PQ == NULL)
+  {
+    printf("\n**Error in CreatePQueue: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  PQ->Elements = (PQueueElementType *)mymalloc(N * sizeof(PQueueElementType));
+  PQ->Priorities = (int *)mymalloc(N * sizeof(int));
+  PQ->Position = (int *)mymalloc(N * sizeof(int));
+  if (PQ->Elements == NULL || PQ->Priorities == NULL || PQ->Position == NULL)
+  {
+    printf("\n**Error in CreatePQueue: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  for (i = 0; i < N; ++i)  // nothing in queue yet:
+    PQ->Position[i] = -1;
+
+  //
+  // initialize fields:
+  //
+  PQ->NumElements = 0;
+  PQ->Capacity = N;
+
+  //
+  // done:
+  //
+  return PQ;
+}
+
+//
+// DeletePQueue:
+//
+// Frees the memory associated with this priority queue.
+//
+void DeletePQueue(PQueue *PQ)
+{
+  myfree(PQ->Elements);
+  myfree(PQ->Priorities);
+  myfree(PQ->Position);
+  myfree(PQ);
+}
+
+//
+// isEmptyPQueue:
+//
+// Returns true (non-zero) if queue is empty, false (0) if not.
+//
+int isEmptyPQueue(PQueue *PQ)
+{
+  return PQ->NumElements == 0;
+}
+
+//
+// isElementInPQueue:
+//
+// Return true (non-zero) if e is currently in PQ, false (0) if not.
+//
+int isElementInPQueue(PQueue *PQ, PQueueElementType e)
+{
+  if (e < 0 || e >= PQ->Capacity)
+    return 0;  /*false*/
+
+  return PQ->Position[e] != -1;
+}
+
+//
+// _pqSwap:
+//
+// Swaps heap slots i and j, keeping Position[] up to date.
+//
+static void _pqSwap(PQueue *PQ, int i, int j)
+{
+  PQueueElementType e = PQ->Elements[i];
+  int               p = PQ->Priorities[i];
+
+  PQ->Elements[i] = PQ->Elements[j];
+  PQ->Priorities[i] = PQ->Priorities[j];
+  PQ->Elements[j] = e;
+  PQ->Priorities[j] = p;
+
+  PQ->Position[PQ->Elements[i]] = i;
+  PQ->Position[PQ->Elements[j]] = j;
+}
+
+//
+// _pqSiftUp / _pqSiftDown:
+//
+// Restore the heap property by moving slot i up towards the root,
+// or down towards the leaves.
+//
+static void _pqSiftUp(PQueue *PQ, int i)
+{
+  while (i > 0)
+  {
+    int parent = (i - 1) / 2;
+
+    if (PQ->Priorities[parent] <= PQ->Priorities[i])  // in order:
+      break;
+
+    _pqSwap(PQ, i, parent);
+    i = parent;
+  }
+}
+
+static void _pqSiftDown(PQueue *PQ, int i)
+{
+  while (1)
+  {
+    int left = 2 * i + 1;
+    int right = left + 1;
+    int smallest = i;
+
+    if (left < PQ->NumElements && PQ->Priorities[left] < PQ->Priorities[smallest])
+      smallest = left;
+    if (right < PQ->NumElements && PQ->Priorities[right] < PQ->Priorities[smallest])
+      smallest = right;
+
+    if (smallest == i)  // in order:
+      break;
+
+    _pqSwap(PQ, i, smallest);
+    i = smallest;
+  }
+}
+
+//
+// PQInsert:
+//
+// Inserts element e with the given priority.  If e is already in
+// the queue, its priority is lowered to the given priority instead
+// (decrease-key); a higher priority is ignored.  Returns true
+// (non-zero) if successful, false (0) if e is out of range.
+//
+int PQInsert(PQueue *PQ, PQueueElementType e, int priority)
+{
+  if (e < 0 || e >= PQ->Capacity)  // invalid element:
+    return 0;  /*false*/
+
+  int i = PQ->Position[e];
+
+  if (i == -1)  // new element, add at the bottom:
+  {
+    i = PQ->NumElements;
+    PQ->NumElements++;
+
+    PQ->Elements[i] = e;
+    PQ->Priorities[i] = priority;
+    PQ->Position[e] = i;
+  }
+  else if (priority < PQ->Priorities[i])  // decrease-key:
+  {
+    PQ->Priorities[i] = priority;
+  }
+  else  // not an improvement:
+    return 1;  /*true*/
+
+  _pqSiftUp(PQ, i);
+
+  return 1;  /*true*/
+}
+
+//
+// PQPopMin:
+//
+// Removes and returns the element with the smallest priority;
+// prints an error message and exits the program if the queue
+// is empty.
+//
+PQueueElementType PQPopMin(PQueue *PQ)
+{
+  if (isEmptyPQueue(PQ))  // nothing to pop?!
+  {
+    printf("\n**Error in PQPopMin: PQ is empty?!\n\n");
+    exit(-1);
+  }
+
+  PQueueElementType minE = PQ->Elements[0];
+
+  //
+  // move last element to the root and sift it down:
+  //
+  PQ->NumElements--;
+
+  if (PQ->NumElements > 0)
+  {
+    _pqSwap(PQ, 0, PQ->NumElements);
+    _pqSiftDown(PQ, 0);
+  }
+
+  PQ->Position[minE] = -1;
+
+  return minE;
+}
+
+//
+// ClearPQueue:
+//
+// Removes all elements from the queue; takes time proportional to
+// the # of elements in the queue, not its capacity.
+//
+void ClearPQueue(PQueue *PQ)
+{
+  int  i;
+
+  for (i = 0; i < PQ->NumElements; ++i)
+    PQ->Position[PQ->Elements[i]] = -1;
+
+  PQ->NumElements = 0;
+}
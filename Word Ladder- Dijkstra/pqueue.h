@@ -0,0 +1,26 @@
+/*pqueue.h*/
+
+//
+// Priority Queue:
+//
+// Binary min-heap of elements 0..N-1, each with an integer priority.
+// Position[] tracks where each element sits in the heap, so an
+// element's priority can be lowered in place (decrease-key).
+//
+typedef int PQueueElementType;
+typedef struct PQueue
+{
+  PQueueElementType *Elements;    // heap of elements, min at [0]
+  int  *Priorities;   // Priorities[i] is priority of Elements[i]
+  int  *Position;     // Position[e] is e's index in heap, -1 if absent
+  int   NumElements;  // # of elements currently in PQ
+  int   Capacity;     // elements must be in range 0..Capacity-1
+} PQueue;
+
+PQueue *CreatePQueue(int N);
+void    DeletePQueue(PQueue *PQ);
+int     isEmptyPQueue(PQueue *PQ);
+int     isElementInPQueue(PQueue *PQ, PQueueElementType e);
+int     PQInsert(PQueue *PQ, PQueueElementType e, int priority);
+PQueueElementType PQPopMin(PQueue *PQ);
+void    ClearPQueue(PQueue *PQ);
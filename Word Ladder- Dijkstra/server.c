@@ -0,0 +1,919 @@
+/*server.c*/
+
+//
+// Query server:  an epoll event loop accepts connections and splits
+// their input into request lines; a pool of worker threads answers
+// the requests against the shared, read-only graph.  Linux only.
+//
+
+#define _GNU_SOURCE
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "nameindex.h"
+#include "workspace.h"
+#include "graph.h"
+#include "batch.h"
+#include "server.h"
+#include "mymem.h"
+#include "timer.h"
+
+
+#define SERVER_MAX_DISTANCE  100  // largest d accepted by BFSD
+#define SERVER_MAX_EVENTS    64   // epoll events handled per wakeup
+#define SERVER_ACCEPT_RETRY  100  // ms to wait before accepting again, when out of fds
+#define SERVER_MAX_PENDING   (64 * 1024)  // unsent bytes per connection before reading stops
+
+
+// #####################################################
+//
+// Text buffers:  a growable array of chars, always '\0'-terminated.
+//
+typedef struct TextBuffer
+{
+  char *Data;
+  int   Size;      // # of chars, not counting the '\0'
+  int   Capacity;
+} TextBuffer;
+
+static void _append(TextBuffer *B, const char *s, int n)
+{
+  if (B->Size + n + 1 > B->Capacity)  // room for the '\0' too:
+  {
+    int   capacity = 2 * B->Capacity + n + 64;
+    char *data = (char *)mymalloc(capacity * sizeof(char));
+    if (data == NULL)
+    {
+      printf("\n**Error in RunServer: malloc failed to allocate\n\n");
+      exit(-1);
+    }
+
+    if (B->Data != NULL)
+    {
+      memcpy(data, B->Data, B->Size);
+      myfree(B->Data);
+    }
+
+    B->Data = data;
+    B->Capacity = capacity;
+  }
+
+  memcpy(B->Data + B->Size, s, n);
+  B->Size += n;
+  B->Data[B->Size] = '\0';
+}
+
+static void _appendString(TextBuffer *B, const char *s)
+{
+  _append(B, s, (int)strlen(s));
+}
+
+static void _appendInt(TextBuffer *B, int i)
+{
+  char  number[16];
+
+  sprintf(number, "%d", i);
+  _appendString(B, number);
+}
+
+static void _consume(TextBuffer *B, int n)  // drop the first n chars:
+{
+  memmove(B->Data, B->Data + n, B->Size - n);
+  B->Size -= n;
+  B->Data[B->Size] = '\0';
+}
+
+static void _freeText(TextBuffer *B)
+{
+  if (B->Data != NULL)
+    myfree(B->Data);
+
+  B->Data = NULL;
+  B->Size = 0;
+  B->Capacity = 0;
+}
+
+
+// #####################################################
+//
+// Answering requests (worker threads):
+//
+
+//
+// _answer:
+//
+// Answers one request line (see server.h), appending the response
+// line, with its '\n', to R.  The request is modified.  W is the
+// calling worker's search workspace.
+//
+static void _answer(Graph *G, int search, SearchWorkspace *W, char *request, TextBuffer *R)
+{
+  char   *save;
+  char   *command = strtok_r(request, " \t", &save);
+  char   *arg1 = strtok_r(NULL, " \t", &save);
+  char   *arg2 = strtok_r(NULL, " \t", &save);
+  char   *extra = strtok_r(NULL, " \t", &save);
+  Vertex  v1, v2;
+  int     i;
+
+  if (command == NULL)
+    _appendString(R, "ERR empty request");
+  else if (strcmp(command, "LADDER") == 0)
+  {
+    if (arg2 == NULL || extra != NULL)
+      _appendString(R, "ERR usage: LADDER src dest");
+    else if ((v1 = Name2Vertex(G, arg1)) < 0 || (v2 = Name2Vertex(G, arg2)) < 0)
+    {
+      _appendString(R, "ERR unknown word '");
+      _appendString(R, (Name2Vertex(G, arg1) < 0) ? arg1 : arg2);
+      _appendString(R, "'");
+    }
+    else
+    {
+      Vertex *ladder = FindLadder(G, v1, v2, search, NULL, W);
+
+      if (ladder[0] == -1)
+        _appendString(R, "NONE");
+      else
+      {
+        for (i = 0; ladder[i] != -1; ++i)  // length is # of edges:
+          ;
+
+        _appendString(R, "OK ");
+        _appendInt(R, i - 1);
+
+        for (i = 0; ladder[i] != -1; ++i)
+        {
+          _appendString(R, " ");
+          _appendString(R, Vertex2Name(G, ladder[i]));
+        }
+      }
+
+      myfree(ladder);
+    }
+  }
+  else if (strcmp(command, "NEIGHBORS") == 0)
+  {
+    if (arg1 == NULL || arg2 != NULL)
+      _appendString(R, "ERR usage: NEIGHBORS word");
+    else if ((v1 = Name2Vertex(G, arg1)) < 0)
+    {
+      _appendString(R, "ERR unknown word '");
+      _appendString(R, arg1);
+      _appendString(R, "'");
+    }
+    else
+    {
+      NeighborSpan neighbors = NeighborsOf(G, v1);
+
+      _appendString(R, "OK ");
+      _appendInt(R, neighbors.Count);
+
+      for (i = 0; i < neighbors.Count; ++i)
+      {
+        _appendString(R, " ");
+        _appendString(R, Vertex2Name(G, neighbors.Vertices[i]));
+      }
+    }
+  }
+  else if (strcmp(command, "BFSD") == 0)
+  {
+    char *end = NULL;
+    long  d = (arg2 == NULL) ? 0 : strtol(arg2, &end, 10);
+
+    if (arg2 == NULL || extra != NULL || *end != '\0' || d < 1 || d > SERVER_MAX_DISTANCE)
+      _appendString(R, "ERR usage: BFSD word d, with 1 <= d <= 100");
+    else if ((v1 = Name2Vertex(G, arg1)) < 0)
+    {
+      _appendString(R, "ERR unknown word '");
+      _appendString(R, arg1);
+      _appendString(R, "'");
+    }
+    else
+    {
+      //
+      // BFSd separates the levels with -1 markers; d+1 of them:
+      //
+      Vertex *V = BFSd(G, v1, (int)d, NULL, W);
+      int     markers = 0;
+
+      _appendString(R, "OK");
+
+      for (i = 0; markers <= d; ++i)
+      {
+        if (V[i] == -1)
+        {
+          ++markers;
+          if (markers <= d)
+            _appendString(R, " |");
+        }
+        else
+        {
+          _appendString(R, " ");
+          _appendString(R, Vertex2Name(G, V[i]));
+        }
+      }
+
+      myfree(V);
+    }
+  }
+  else
+  {
+    _appendString(R, "ERR unknown command '");
+    _appendString(R, command);
+    _appendString(R, "'");
+  }
+
+  _appendString(R, "\n");
+}
+
+
+// #####################################################
+//
+// Server state:
+//
+// A connection has at most one request with the workers at a time
+// (Busy); the next one is only handed out once the response is back,
+// which keeps the responses in request order.  A connection is never
+// closed while Busy.
+//
+typedef struct ServerConn
+{
+  int         Fd;
+  TextBuffer  In;          // received, not yet handed out
+  TextBuffer  Out;         // responses not yet sent
+  int         Events;      // epoll events watched, 0 => not watched
+  int         Busy;        // a request is with the workers
+  int         EndOfInput;  // client has stopped sending
+  int         Closing;     // close once the responses are sent
+  int         Broken;      // connection failed, close asap
+} ServerConn;
+
+typedef struct ServerJob
+{
+  ServerConn       *Conn;
+  char             *Request;
+  TextBuffer        Response;
+  struct ServerJob *Next;
+} ServerJob;
+
+struct Server;
+
+typedef struct ServerWorker
+{
+  struct Server   *S;
+  SearchWorkspace *W;
+  pthread_t        Thread;
+} ServerWorker;
+
+typedef struct Server
+{
+  Graph          *G;
+  int             Search;
+  int             ListenFd;
+  int             ListenEvents;  // epoll events watched for ListenFd, 0 => out of fds
+  int             EpollFd;
+  int             WakeFd;     // eventfd:  workers => event loop
+  int             SignalFd;   // SIGINT/SIGTERM => event loop
+  ServerConn    **Conns;      // Conns[fd], or NULL
+  int             NumConns;   // # of entries in Conns
+  pthread_mutex_t Lock;       // guards the queues and Stopping:
+  pthread_cond_t  JobReady;
+  ServerJob      *PendingHead, *PendingTail;  // requests for the workers
+  ServerJob      *DoneHead, *DoneTail;        // responses for the loop
+  int             Stopping;
+} Server;
+
+static void _push(ServerJob **head, ServerJob **tail, ServerJob *J)
+{
+  J->Next = NULL;
+
+  if (*tail == NULL)
+    *head = J;
+  else
+    (*tail)->Next = J;
+
+  *tail = J;
+}
+
+static ServerJob *_pop(ServerJob **head, ServerJob **tail)
+{
+  ServerJob *J = *head;
+
+  if (J != NULL)
+  {
+    *head = J->Next;
+    if (*head == NULL)
+      *tail = NULL;
+  }
+
+  return J;
+}
+
+static void _freeJob(ServerJob *J)
+{
+  myfree(J->Request);
+  _freeText(&J->Response);
+  myfree(J);
+}
+
+//
+// _runWorker:
+//
+// Worker thread:  answers pending requests until the server stops,
+// and wakes up the event loop after each one.
+//
+static void *_runWorker(void *arg)
+{
+  ServerWorker *SW = (ServerWorker *)arg;
+  Server       *S = SW->S;
+  uint64_t      one = 1;
+
+  while (1)
+  {
+    pthread_mutex_lock(&S->Lock);
+
+    while (S->PendingHead == NULL && !S->Stopping)
+      pthread_cond_wait(&S->JobReady, &S->Lock);
+
+    ServerJob *J = _pop(&S->PendingHead, &S->PendingTail);
+
+    pthread_mutex_unlock(&S->Lock);
+
+    if (J == NULL)  // stopping:
+      break;
+
+    timer_begin("answer request");
+    _answer(S->G, S->Search, SW->W, J->Request, &J->Response);
+    timer_end();
+
+    pthread_mutex_lock(&S->Lock);
+    _push(&S->DoneHead, &S->DoneTail, J);
+    pthread_mutex_unlock(&S->Lock);
+
+    if (write(S->WakeFd, &one, sizeof(one)) < 0)
+    {
+      // only fails if the counter is full, so the loop wakes anyway
+    }
+  }
+
+  return NULL;
+}
+
+
+// #####################################################
+//
+// Event loop:
+//
+
+//
+// _watch:
+//
+// Sets the epoll events watched for fd, adding or removing it from
+// the epoll set as needed; *current is updated.  An fd must not
+// stay in the set with no events:  epoll would still report hang-ups
+// for it, over and over.
+//
+static void _watch(Server *S, int fd, int *current, int events)
+{
+  struct epoll_event  ev;
+
+  if (events == *current)
+    return;
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.fd = fd;
+
+  if (events == 0)
+    epoll_ctl(S->EpollFd, EPOLL_CTL_DEL, fd, &ev);
+  else if (*current == 0)
+    epoll_ctl(S->EpollFd, EPOLL_CTL_ADD, fd, &ev);
+  else
+    epoll_ctl(S->EpollFd, EPOLL_CTL_MOD, fd, &ev);
+
+  *current = events;
+}
+
+static void _closeConn(Server *S, ServerConn *C)
+{
+  _watch(S, C->Fd, &C->Events, 0);
+  close(C->Fd);
+
+  S->Conns[C->Fd] = NULL;
+
+  _freeText(&C->In);
+  _freeText(&C->Out);
+  myfree(C);
+
+  // an fd is free again, so resume accepting if we ran out:
+  _watch(S, S->ListenFd, &S->ListenEvents, EPOLLIN);
+}
+
+//
+// _acceptConns:
+//
+// Accepts all waiting connections, and starts watching them.  If
+// the process (or system) is out of fds, or memory, the waiting
+// connections stay queued:  ListenFd is no longer watched --- it
+// would stay readable, and the event loop would spin --- until a
+// connection closes, or SERVER_ACCEPT_RETRY ms pass.
+//
+static void _acceptConns(Server *S)
+{
+  while (1)
+  {
+    int fd = accept4(S->ListenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if (fd < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)  // none left:
+        break;
+      else if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO)  // that one's gone, try the next:
+        continue;
+
+      // EMFILE, ENFILE, ENOBUFS, ENOMEM, ...:  pause accepting
+      _watch(S, S->ListenFd, &S->ListenEvents, 0);
+      break;
+    }
+
+    if (fd >= S->NumConns)  // grow table to cover fd:
+    {
+      int          n = 2 * fd + 16;
+      ServerConn **conns = (ServerConn **)mymalloc(n * sizeof(ServerConn *));
+      if (conns == NULL)
+      {
+        printf("\n**Error in RunServer: malloc failed to allocate\n\n");
+        exit(-1);
+      }
+
+      memset(conns, 0, n * sizeof(ServerConn *));
+      if (S->Conns != NULL)
+      {
+        memcpy(conns, S->Conns, S->NumConns * sizeof(ServerConn *));
+        myfree(S->Conns);
+      }
+
+      S->Conns = conns;
+      S->NumConns = n;
+    }
+
+    ServerConn *C = (ServerConn *)mymalloc(sizeof(ServerConn));
+    if (C == NULL)
+    {
+      printf("\n**Error in RunServer: malloc failed to allocate\n\n");
+      exit(-1);
+    }
+
+    memset(C, 0, sizeof(ServerConn));
+    C->Fd = fd;
+    S->Conns[fd] = C;
+
+    _watch(S, fd, &C->Events, EPOLLIN);
+  }
+}
+
+//
+// _readConn / _flushConn:
+//
+// Receive what's available into In, but stop once In holds more
+// than the longest request, so a fast sender can't make it grow
+// without limit (the rest waits in the socket until the requests
+// already in In are handled, or one is found to be too long); send
+// as much of Out as the socket will take.  Neither blocks.
+//
+static void _readConn(ServerConn *C)
+{
+  char  data[4096];
+
+  while (!C->EndOfInput && !C->Broken && C->In.Size <= SERVER_MAX_LINE)
+  {
+    ssize_t n = recv(C->Fd, data, sizeof(data), 0);
+
+    if (n > 0)
+      _append(&C->In, data, (int)n);
+    else if (n == 0)
+      C->EndOfInput = 1;  /*true*/
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+      break;
+    else if (errno != EINTR)
+      C->Broken = 1;  /*true*/
+  }
+}
+
+static void _flushConn(ServerConn *C)
+{
+  while (C->Out.Size > 0 && !C->Broken)
+  {
+    ssize_t n = send(C->Fd, C->Out.Data, C->Out.Size, MSG_NOSIGNAL);
+
+    if (n > 0)
+      _consume(&C->Out, (int)n);
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+      break;
+    else if (errno != EINTR)
+      C->Broken = 1;  /*true*/
+  }
+}
+
+//
+// _serviceConn:
+//
+// Moves a connection along after something happened to it:  sends
+// pending responses, hands the next complete request line to the
+// workers if the connection is idle, and then either closes the
+// connection or updates the events watched for it.  A client that
+// sends requests but doesn't read the responses is held back:  once
+// more than SERVER_MAX_PENDING bytes are unsent, no more requests
+// are taken and the connection isn't read, until sending brings Out
+// back under the mark.
+//
+static void _serviceConn(Server *S, ServerConn *C)
+{
+  _flushConn(C);
+
+  while (!C->Busy && !C->Closing && !C->Broken && C->Out.Size <= SERVER_MAX_PENDING)
+  {
+    char *eol = (C->In.Data == NULL) ? NULL : (char *)memchr(C->In.Data, '\n', C->In.Size);
+
+    if (eol == NULL)  // no complete request:
+    {
+      if (C->In.Size > SERVER_MAX_LINE)
+      {
+        _appendString(&C->Out, "ERR request too long\n");
+        C->Closing = 1;  /*true*/
+      }
+      else if (C->EndOfInput)
+        C->Closing = 1;  /*true*/
+
+      break;
+    }
+
+    int n = (int)(eol - C->In.Data);
+
+    char *request = (char *)mymalloc((n + 1) * sizeof(char));
+    if (request == NULL)
+    {
+      printf("\n**Error in RunServer: malloc failed to allocate\n\n");
+      exit(-1);
+    }
+
+    memcpy(request, C->In.Data, n);
+    request[n] = '\0';
+    request[strcspn(request, "\r")] = '\0';  // strip EOL(s) char at end:
+    _consume(&C->In, n + 1);
+
+    if (n > SERVER_MAX_LINE)
+    {
+      _appendString(&C->Out, "ERR request too long\n");
+      myfree(request);
+    }
+    else if (strcmp(request, "QUIT") == 0)
+    {
+      _appendString(&C->Out, "BYE\n");
+      C->Closing = 1;  /*true*/
+      myfree(request);
+    }
+    else  // over to the workers:
+    {
+      ServerJob *J = (ServerJob *)mymalloc(sizeof(ServerJob));
+      if (J == NULL)
+      {
+        printf("\n**Error in RunServer: malloc failed to allocate\n\n");
+        exit(-1);
+      }
+
+      memset(J, 0, sizeof(ServerJob));
+      J->Conn = C;
+      J->Request = request;
+
+      C->Busy = 1;  /*true*/
+
+      pthread_mutex_lock(&S->Lock);
+      _push(&S->PendingHead, &S->PendingTail, J);
+      pthread_cond_signal(&S->JobReady);
+      pthread_mutex_unlock(&S->Lock);
+    }
+  }
+
+  _flushConn(C);
+
+  if (C->Busy)  // wait for the response, but don't read ahead:
+    _watch(S, C->Fd, &C->Events, (C->Out.Size > 0 && !C->Broken) ? EPOLLOUT : 0);
+  else if (C->Broken || (C->Closing && C->Out.Size == 0))
+    _closeConn(S, C);
+  else
+  {
+    int reading = !C->Closing && !C->EndOfInput && C->Out.Size <= SERVER_MAX_PENDING;
+
+    _watch(S, C->Fd, &C->Events, (reading ? EPOLLIN : 0) | (C->Out.Size > 0 ? EPOLLOUT : 0));
+  }
+}
+
+//
+// _collectResponses:
+//
+// Appends the workers' finished responses to their connections'
+// output, and moves those connections along.
+//
+static void _collectResponses(Server *S)
+{
+  uint64_t  count;
+
+  if (read(S->WakeFd, &count, sizeof(count)) < 0)  // reset the counter:
+  {
+    // already zero, nothing to reset
+  }
+
+  pthread_mutex_lock(&S->Lock);
+  ServerJob *J = S->DoneHead;
+  S->DoneHead = NULL;
+  S->DoneTail = NULL;
+  pthread_mutex_unlock(&S->Lock);
+
+  while (J != NULL)
+  {
+    ServerJob  *next = J->Next;
+    ServerConn *C = J->Conn;
+
+    C->Busy = 0;  /*false*/
+
+    if (!C->Broken)
+      _append(&C->Out, J->Response.Data, J->Response.Size);
+
+    _freeJob(J);
+    _serviceConn(S, C);
+
+    J = next;
+  }
+}
+
+//
+// _listenOn:
+//
+// Creates a non-blocking socket listening on the given address:
+// a port # => 127.0.0.1:port, anything else => the path of a Unix
+// domain socket.  A stale socket file at that path is removed first.
+// Returns the socket, or -1 (after printing an error) on failure.
+//
+static int _listenOn(char *address)
+{
+  int  fd;
+  int  isPort = (address[0] != '\0' && strspn(address, "0123456789") == strlen(address));
+
+  if (isPort)
+  {
+    struct sockaddr_in  sin;
+    int                 yes = 1;
+    long                port = strtol(address, NULL, 10);
+
+    if (port < 1 || port > 65535)
+    {
+      printf("**ERROR: invalid port '%s'\n\n", address);
+      return -1;
+    }
+
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons((unsigned short)port);
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd >= 0)
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    if (fd < 0 || bind(fd, (struct sockaddr *)&sin, sizeof(sin)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+      printf("**ERROR: unable to listen on port %ld: %s\n\n", port, strerror(errno));
+      if (fd >= 0)
+        close(fd);
+      return -1;
+    }
+  }
+  else
+  {
+    struct sockaddr_un  sun;
+    struct stat         st;
+
+    if (strlen(address) >= sizeof(sun.sun_path))
+    {
+      printf("**ERROR: socket path '%s' is too long\n\n", address);
+      return -1;
+    }
+
+    memset(&sun, 0, sizeof(sun));
+    sun.sun_family = AF_UNIX;
+    strcpy(sun.sun_path, address);
+
+    if (stat(address, &st) == 0 && S_ISSOCK(st.st_mode))  // stale:
+      unlink(address);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0 || bind(fd, (struct sockaddr *)&sun, sizeof(sun)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+      printf("**ERROR: unable to listen on '%s': %s\n\n", address, strerror(errno));
+      if (fd >= 0)
+        close(fd);
+      return -1;
+    }
+  }
+
+  return fd;
+}
+
+
+//
+// RunServer:
+//
+// Serves queries on the given address (see _listenOn) until the
+// process receives SIGINT or SIGTERM, answering them with numThreads
+// worker threads, each with its own search workspace; ladders are
+// found with the given search (SEARCH_...).  G is shared, and must
+// not change meanwhile.  Returns true (non-zero) once stopped, false
+// (0) if the server could not be started.
+//
+int RunServer(Graph *G, int search, char *address, int numThreads)
+{
+  Server              S;
+  ServerWorker       *workers;
+  struct epoll_event  ev, events[SERVER_MAX_EVENTS];
+  sigset_t            signals, oldSignals;
+  int                 t, i;
+
+  if (numThreads < 1)
+    numThreads = 1;
+
+  memset(&S, 0, sizeof(S));
+  S.G = G;
+  S.Search = search;
+
+  S.ListenFd = _listenOn(address);
+  if (S.ListenFd < 0)
+    return 0;  /*false*/
+
+  //
+  // SIGINT/SIGTERM are delivered through a signalfd; block them
+  // before starting the workers, so the workers inherit the mask:
+  //
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, &oldSignals);
+
+  S.EpollFd = epoll_create1(EPOLL_CLOEXEC);
+  S.WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  S.SignalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (S.EpollFd < 0 || S.WakeFd < 0 || S.SignalFd < 0)
+  {
+    printf("\n**Error in RunServer: unable to create epoll/eventfd/signalfd\n\n");
+    exit(-1);
+  }
+
+  _watch(&S, S.ListenFd, &S.ListenEvents, EPOLLIN);
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = S.WakeFd;
+  epoll_ctl(S.EpollFd, EPOLL_CTL_ADD, S.WakeFd, &ev);
+  ev.data.fd = S.SignalFd;
+  epoll_ctl(S.EpollFd, EPOLL_CTL_ADD, S.SignalFd, &ev);
+
+  pthread_mutex_init(&S.Lock, NULL);
+  pthread_cond_init(&S.JobReady, NULL);
+
+  workers = (ServerWorker *)mymalloc(numThreads * sizeof(ServerWorker));
+  if (workers == NULL)
+  {
+    printf("\n**Error in RunServer: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  for (t = 0; t < numThreads; ++t)
+  {
+    workers[t].S = &S;
+    workers[t].W = CreateSearchWorkspace(G->NumVertices);
+
+    if (pthread_create(&workers[t].Thread, NULL, _runWorker, &workers[t]) != 0)
+    {
+      printf("\n**Error in RunServer: unable to create thread\n\n");
+      exit(-1);
+    }
+  }
+
+  printf(">>Serving on '%s' with %d thread(s); SIGINT or SIGTERM to stop\n", address, numThreads);
+  fflush(stdout);
+
+  //
+  // event loop:
+  //
+  int  running = 1;  /*true*/
+
+  while (running)
+  {
+    int n = epoll_wait(S.EpollFd, events, SERVER_MAX_EVENTS,
+                       (S.ListenEvents == 0) ? SERVER_ACCEPT_RETRY : -1);
+
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      printf("\n**Error in RunServer: epoll_wait failed: %s\n\n", strerror(errno));
+      break;
+    }
+
+    if (n == 0)  // timed out, while out of fds:  try accepting again
+      _watch(&S, S.ListenFd, &S.ListenEvents, EPOLLIN);
+
+    for (i = 0; i < n; ++i)
+    {
+      int fd = events[i].data.fd;
+
+      if (fd == S.ListenFd)
+        _acceptConns(&S);
+      else if (fd == S.WakeFd)
+        _collectResponses(&S);
+      else if (fd == S.SignalFd)  // consume the signal, so it's not delivered later:
+      {
+        struct signalfd_siginfo  info;
+
+        if (read(S.SignalFd, &info, sizeof(info)) == sizeof(info))
+          running = 0;  /*false*/
+      }
+      else if (fd < S.NumConns && S.Conns[fd] != NULL)
+      {
+        ServerConn *C = S.Conns[fd];
+
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+          _readConn(C);
+
+        _serviceConn(&S, C);
+      }
+    }
+  }
+
+  //
+  // stop:  the workers finish the pending requests and exit; then
+  // everything is closed, answered or not:
+  //
+  pthread_mutex_lock(&S.Lock);
+  S.Stopping = 1;  /*true*/
+  pthread_cond_broadcast(&S.JobReady);
+  pthread_mutex_unlock(&S.Lock);
+
+  for (t = 0; t < numThreads; ++t)
+  {
+    pthread_join(workers[t].Thread, NULL);
+    DeleteSearchWorkspace(workers[t].W);
+  }
+
+  ServerJob *J;
+
+  while ((J = _pop(&S.DoneHead, &S.DoneTail)) != NULL)
+    _freeJob(J);
+
+  for (i = 0; i < S.NumConns; ++i)
+  {
+    if (S.Conns[i] != NULL)
+      _closeConn(&S, S.Conns[i]);
+  }
+
+  if (S.Conns != NULL)
+    myfree(S.Conns);
+  myfree(workers);
+
+  close(S.ListenFd);
+  close(S.EpollFd);
+  close(S.WakeFd);
+  close(S.SignalFd);
+
+  if (strspn(address, "0123456789") != strlen(address))  // Unix socket:
+    unlink(address);
+
+  pthread_mutex_destroy(&S.Lock);
+  pthread_cond_destroy(&S.JobReady);
+  pthread_sigmask(SIG_SETMASK, &oldSignals, NULL);
+
+  printf(">>Server stopped\n");
+
+  return 1;  /*true*/
+}
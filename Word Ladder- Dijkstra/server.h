@@ -0,0 +1,21 @@
+/*server.h*/
+
+//
+// Query server:  keeps one graph in memory and answers queries from
+// local clients over a Unix domain socket or a loopback TCP port.
+// Each request and response is one line of text:
+//
+//   LADDER src dest    =>  OK <length> <src> ... <dest>
+//                          NONE                 (no ladder)
+//   NEIGHBORS word     =>  OK <count> <word> ...
+//   BFSD word d        =>  OK <level 0> | <level 1> | ... | <level d>
+//                          (each level is 0 or more words)
+//   QUIT               =>  BYE, and the server closes the connection
+//
+// Anything else is answered with "ERR <reason>".  A client may send
+// several requests without waiting; the responses come back in the
+// same order.  See client.c for a client.
+//
+#define SERVER_MAX_LINE  1024  // longest request accepted, in chars
+
+int RunServer(Graph *G, int search, char *address, int numThreads);
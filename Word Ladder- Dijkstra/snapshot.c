@@ -0,0 +1,566 @@
+/*snapshot.c*/
+
+//
+// Graph snapshots:  save a frozen graph to a binary file, and load
+// it back by mapping the file into memory (POSIX mmap).
+//
+
+#define _POSIX_C_SOURCE 200809L
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "nameindex.h"
+#include "workspace.h"
+#include "graph.h"
+#include "snapshot.h"
+#include "mymem.h"
+
+
+//
+// File layout:  a fixed-size header, followed by these sections,
+// each starting on an 8-byte boundary:
+//
+//   NameOffsets  int32[NumVertices+1]  name of v starts at NameChars[NameOffsets[v]]
+//   NameChars    char[]                the names, each '\0'-terminated
+//   Index        int32[IndexSize]      name index: hash table slots (open
+//                                      addressing), or per-bucket displacements
+//                                      (perfect hash)
+//   IndexAux     int32[]               name index: NameHash() of each slot
+//                                      (open addressing, IndexSize entries), or
+//                                      vertex in each slot (perfect hash,
+//                                      IndexElements entries)
+//   Offsets      int32[NumVertices+1]  CSR row offsets
+//   Dests        int32[NumEdges]       CSR edge destinations
+//   Weights      int32[NumEdges]       CSR edge weights
+//   Components   int32[NumVertices]    component id of each vertex
+//   ComponentSizes  int32[NumComponents]  # of vertices in each component
+//
+// Numbers are stored in the byte order of the machine that wrote the
+// file; ByteOrder lets a reader detect a mismatch.  Checksum is the
+// 64-bit FNV-1a hash of everything after the header.
+//
+#define SNAPSHOT_MAGIC       "WLGRAPH"
+#define SNAPSHOT_BYTE_ORDER  0x01020304u
+
+#define SNAPSHOT_INDEX_OPEN     0
+#define SNAPSHOT_INDEX_PERFECT  1
+
+typedef struct SnapshotHeader
+{
+  char      Magic[8];
+  uint32_t  Version;
+  uint32_t  ByteOrder;
+  uint32_t  NumVertices;
+  uint32_t  NumEdges;
+  uint32_t  Symmetric;
+  uint32_t  IndexKind;      // SNAPSHOT_INDEX_OPEN or SNAPSHOT_INDEX_PERFECT
+  uint32_t  IndexSize;      // # of slots, or # of buckets
+  uint32_t  IndexElements;  // # of names in the index
+  uint32_t  NumComponents;
+  uint32_t  Reserved;       // 0, keeps the offsets below 8-byte aligned
+  uint64_t  NameOffsetsAt;  // file offset of each section:
+  uint64_t  NameCharsAt;
+  uint64_t  IndexAt;
+  uint64_t  IndexAuxAt;
+  uint64_t  OffsetsAt;
+  uint64_t  DestsAt;
+  uint64_t  WeightsAt;
+  uint64_t  ComponentsAt;
+  uint64_t  ComponentSizesAt;
+  uint64_t  FileSize;
+  uint64_t  Checksum;
+} SnapshotHeader;
+
+#define FNV_OFFSET  14695981039346656037ULL
+#define FNV_PRIME   1099511628211ULL
+
+static uint64_t _fnv1a(uint64_t h, const void *data, size_t n)
+{
+  const unsigned char *p = (const unsigned char *)data;
+  size_t  i;
+
+  for (i = 0; i < n; ++i)
+  {
+    h ^= p[i];
+    h *= FNV_PRIME;
+  }
+
+  return h;
+}
+
+static uint64_t _align8(uint64_t pos)
+{
+  return (pos + 7) & ~((uint64_t)7);
+}
+
+
+// #####################################################
+//
+// Saving:
+//
+
+//
+// SnapshotWriter:  output file, current position, and running
+// checksum of everything written after the header.
+//
+typedef struct SnapshotWriter
+{
+  FILE     *File;
+  uint64_t  Pos;
+  uint64_t  Checksum;
+  int       Failed;
+} SnapshotWriter;
+
+static void _write(SnapshotWriter *W, const void *data, size_t n)
+{
+  if (n == 0)
+    return;
+
+  if (fwrite(data, 1, n, W->File) != n)
+    W->Failed = 1;  /*true*/
+
+  W->Checksum = _fnv1a(W->Checksum, data, n);
+  W->Pos += n;
+}
+
+static void _pad(SnapshotWriter *W)  // zero-fill up to next 8-byte boundary:
+{
+  static const char zeros[8] = { 0 };
+
+  _write(W, zeros, (size_t)(_align8(W->Pos) - W->Pos));
+}
+
+//
+// SaveGraphSnapshot:
+//
+// Writes the frozen graph G to the given file.  The file is written
+// under a temporary name and then renamed, so an existing snapshot
+// is replaced only once the new one is complete.  Returns true
+// (non-zero) if successful, false (0) if not.
+//
+int SaveGraphSnapshot(Graph *G, char *filename)
+{
+  SnapshotHeader  H;
+  SnapshotWriter  W;
+  int      N = G->NumVertices;
+
+  if (!G->Frozen)
+  {
+    printf("\n**Error in SaveGraphSnapshot: graph is not frozen.\n\n");
+    return 0;
+  }
+
+  //
+  // the name arena and name index are saved as is:
+  //
+  NameIndex *I = G->NamesIndex;
+
+  if (I->NumElements != N)
+  {
+    printf("\n**Error in SaveGraphSnapshot: vertex names are not unique.\n\n");
+    return 0;
+  }
+
+  void     *index, *indexAux;
+  uint32_t  indexKind, indexSize;
+  uint64_t  indexBytes, indexAuxBytes;
+
+  if (I->Perfect != NULL)
+  {
+    indexKind = SNAPSHOT_INDEX_PERFECT;
+    indexSize = (uint32_t)I->NumBuckets;
+    index = I->Displace;
+    indexAux = I->Perfect;
+    indexBytes = I->NumBuckets * sizeof(int32_t);
+    indexAuxBytes = I->NumElements * sizeof(int32_t);
+  }
+  else
+  {
+    indexKind = SNAPSHOT_INDEX_OPEN;
+    indexSize = (uint32_t)I->NumSlots;
+    index = I->Slots;
+    indexAux = I->Hashes;
+    indexBytes = I->NumSlots * sizeof(int32_t);
+    indexAuxBytes = I->NumSlots * sizeof(uint32_t);
+  }
+
+  uint64_t nameChars = (uint64_t)G->NameOffsets[N];
+
+  //
+  // lay out the sections:
+  //
+  memset(&H, 0, sizeof(H));
+  strcpy(H.Magic, SNAPSHOT_MAGIC);
+  H.Version = SNAPSHOT_VERSION;
+  H.ByteOrder = SNAPSHOT_BYTE_ORDER;
+  H.NumVertices = (uint32_t)N;
+  H.NumEdges = (uint32_t)G->NumEdges;
+  H.Symmetric = (uint32_t)G->Symmetric;
+  H.IndexKind = indexKind;
+  H.IndexSize = indexSize;
+  H.IndexElements = (uint32_t)I->NumElements;
+  H.NumComponents = (uint32_t)G->NumComponents;
+
+  H.NameOffsetsAt = _align8(sizeof(H));
+  H.NameCharsAt = _align8(H.NameOffsetsAt + (N + 1) * sizeof(int32_t));
+  H.IndexAt = _align8(H.NameCharsAt + nameChars);
+  H.IndexAuxAt = _align8(H.IndexAt + indexBytes);
+  H.OffsetsAt = _align8(H.IndexAuxAt + indexAuxBytes);
+  H.DestsAt = _align8(H.OffsetsAt + (N + 1) * sizeof(int32_t));
+  H.WeightsAt = _align8(H.DestsAt + G->NumEdges * sizeof(int32_t));
+  H.ComponentsAt = _align8(H.WeightsAt + G->NumEdges * sizeof(int32_t));
+  H.ComponentSizesAt = _align8(H.ComponentsAt + N * sizeof(int32_t));
+  H.FileSize = H.ComponentSizesAt + G->NumComponents * sizeof(int32_t);
+
+  //
+  // write header (checksum not yet known), then the sections:
+  //
+  char *tempname = (char *)mymalloc((int)(strlen(filename) + 5));
+  if (tempname == NULL)
+  {
+    printf("\n**Error in SaveGraphSnapshot: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  strcpy(tempname, filename);
+  strcat(tempname, ".tmp");
+
+  W.File = fopen(tempname, "wb");
+  W.Pos = 0;
+  W.Checksum = FNV_OFFSET;
+  W.Failed = 0;  /*false*/
+
+  if (W.File == NULL)
+  {
+    printf("\n**Error in SaveGraphSnapshot: unable to create '%s'\n\n", tempname);
+    myfree(tempname);
+    return 0;
+  }
+
+  _write(&W, &H, sizeof(H));
+  W.Checksum = FNV_OFFSET;  // the header is not part of the checksum:
+
+  _pad(&W);
+  _write(&W, G->NameOffsets, (N + 1) * sizeof(int32_t));
+  _pad(&W);
+  _write(&W, G->NameChars, (size_t)nameChars);
+  _pad(&W);
+  _write(&W, index, (size_t)indexBytes);
+  _pad(&W);
+  _write(&W, indexAux, (size_t)indexAuxBytes);
+  _pad(&W);
+  _write(&W, G->Offsets, (N + 1) * sizeof(int32_t));
+  _pad(&W);
+  _write(&W, G->Dests, G->NumEdges * sizeof(int32_t));
+  _pad(&W);
+  _write(&W, G->Weights, G->NumEdges * sizeof(int32_t));
+  _pad(&W);
+  _write(&W, G->Component, N * sizeof(int32_t));
+  _pad(&W);
+  _write(&W, G->ComponentSizes, G->NumComponents * sizeof(int32_t));
+
+  assert(W.Failed || W.Pos == H.FileSize);
+
+  //
+  // now go back and fill in the checksum:
+  //
+  H.Checksum = W.Checksum;
+
+  if (fseek(W.File, 0, SEEK_SET) != 0 || fwrite(&H, sizeof(H), 1, W.File) != 1)
+    W.Failed = 1;  /*true*/
+  if (fclose(W.File) != 0)
+    W.Failed = 1;  /*true*/
+
+  if (!W.Failed && rename(tempname, filename) != 0)
+    W.Failed = 1;  /*true*/
+
+  if (W.Failed)
+  {
+    printf("\n**Error in SaveGraphSnapshot: unable to write '%s'\n\n", filename);
+    remove(tempname);
+  }
+
+  //
+  // done:
+  //
+  myfree(tempname);
+
+  return !W.Failed;
+}
+
+
+// #####################################################
+//
+// Loading:
+//
+
+//
+// _sectionOK:
+//
+// Returns true if the section [at, at+size) lies within the file
+// and is suitably aligned for int32 data.
+//
+static int _sectionOK(SnapshotHeader *H, uint64_t at, uint64_t size)
+{
+  return at >= sizeof(SnapshotHeader) && at % 4 == 0 &&
+         at <= H->FileSize && size <= H->FileSize - at;
+}
+
+//
+// LoadGraphSnapshot:
+//
+// Maps the given snapshot file into memory and returns a frozen
+// graph whose names, name index and CSR arrays point into the
+// mapping.  The header and checksum are verified first.  Returns
+// NULL (after printing an error) if the file cannot be opened or
+// is not a valid snapshot.
+//
+Graph *LoadGraphSnapshot(char *filename)
+{
+  struct stat  st;
+  int          fd;
+
+  fd = open(filename, O_RDONLY);
+  if (fd < 0)
+  {
+    printf("**ERROR: '%s' not found\n\n", filename);
+    return NULL;
+  }
+
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapshotHeader))
+  {
+    printf("**ERROR: '%s' is not a graph snapshot\n\n", filename);
+    close(fd);
+    return NULL;
+  }
+
+  void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // the mapping stays valid:
+
+  if (map == MAP_FAILED)
+  {
+    printf("**ERROR: unable to map '%s'\n\n", filename);
+    return NULL;
+  }
+
+  //
+  // check the header, the section bounds, and the checksum:
+  //
+  char           *base = (char *)map;
+  SnapshotHeader *H = (SnapshotHeader *)map;
+  uint64_t        N = H->NumVertices;
+  uint64_t        E = H->NumEdges;
+  uint64_t        S = H->IndexSize;
+  uint64_t        K = H->NumComponents;
+  uint64_t        auxSize = (H->IndexKind == SNAPSHOT_INDEX_PERFECT) ? N : S;
+  char           *problem = NULL;
+
+  if (memcmp(H->Magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+    problem = "not a graph snapshot";
+  else if (H->ByteOrder != SNAPSHOT_BYTE_ORDER)
+    problem = "written on a machine with a different byte order";
+  else if (H->Version != SNAPSHOT_VERSION)
+    problem = "unsupported snapshot version";
+  else if (H->FileSize != (uint64_t)st.st_size)
+    problem = "file is truncated";
+  else if (!_sectionOK(H, H->NameOffsetsAt, (N + 1) * 4) ||
+           !_sectionOK(H, H->NameCharsAt, 0) ||
+           !_sectionOK(H, H->IndexAt, S * 4) ||
+           !_sectionOK(H, H->IndexAuxAt, auxSize * 4) ||
+           !_sectionOK(H, H->OffsetsAt, (N + 1) * 4) ||
+           !_sectionOK(H, H->DestsAt, E * 4) ||
+           !_sectionOK(H, H->WeightsAt, E * 4) ||
+           !_sectionOK(H, H->ComponentsAt, N * 4) ||
+           !_sectionOK(H, H->ComponentSizesAt, K * 4))
+    problem = "corrupt section table";
+  else if (_fnv1a(FNV_OFFSET, base + sizeof(SnapshotHeader), (size_t)(H->FileSize - sizeof(SnapshotHeader))) != H->Checksum)
+    problem = "checksum mismatch";
+
+  int32_t *nameOffsets = (int32_t *)(base + H->NameOffsetsAt);
+  int32_t *offsets = (int32_t *)(base + H->OffsetsAt);
+
+  if (problem == NULL)
+  {
+    uint64_t nameChars = H->IndexAt - H->NameCharsAt;
+
+    if (H->IndexAt < H->NameCharsAt || nameOffsets[0] != 0 ||
+        (uint64_t)nameOffsets[N] > nameChars || offsets[N] != (int32_t)E ||
+        (N > 0 && base[H->NameCharsAt + nameOffsets[N] - 1] != '\0'))
+      problem = "corrupt section table";
+  }
+
+  if (problem == NULL)  // each name must end just before the next one starts:
+  {
+    uint64_t v;
+
+    for (v = 0; v < N && problem == NULL; ++v)
+      if (nameOffsets[v + 1] <= nameOffsets[v] || base[H->NameCharsAt + nameOffsets[v + 1] - 1] != '\0')
+        problem = "corrupt name table";
+  }
+
+  int32_t *dests = (int32_t *)(base + H->DestsAt);
+  int32_t *weights = (int32_t *)(base + H->WeightsAt);
+
+  if (problem == NULL)  // each row within the edge arrays, each edge to a valid vertex:
+  {
+    uint64_t i;
+
+    if (offsets[0] != 0)
+      problem = "corrupt edge table";
+    for (i = 0; i < N && problem == NULL; ++i)
+      if (offsets[i + 1] < offsets[i])
+        problem = "corrupt edge table";
+    for (i = 0; i < E && problem == NULL; ++i)
+      if (dests[i] < 0 || (uint64_t)dests[i] >= N || weights[i] < 1)
+        problem = "corrupt edge table";
+  }
+
+  int32_t *index = (int32_t *)(base + H->IndexAt);
+  int32_t *indexAux = (int32_t *)(base + H->IndexAuxAt);
+
+  if (problem == NULL)  // name index must only refer to valid slots and vertices:
+  {
+    uint64_t i;
+
+    if (H->IndexElements != N)
+      problem = "corrupt name index";
+    else if (H->IndexKind == SNAPSHOT_INDEX_PERFECT)
+    {
+      if (N > 0 && S == 0)
+        problem = "corrupt name index";
+      for (i = 0; i < S && problem == NULL; ++i)
+        if (index[i] < 0 && (uint64_t)(-(int64_t)index[i] - 1) >= N)
+          problem = "corrupt name index";
+      for (i = 0; i < N && problem == NULL; ++i)
+        if (indexAux[i] < 0 || (uint64_t)indexAux[i] >= N)
+          problem = "corrupt name index";
+    }
+    else if (H->IndexKind == SNAPSHOT_INDEX_OPEN)
+    {
+      if (S < 2 * N || S == 0 || (S & (S - 1)) != 0)  // power of 2, at most half full:
+        problem = "corrupt name index";
+      for (i = 0; i < S && problem == NULL; ++i)
+        if (index[i] < -1 || (index[i] >= 0 && (uint64_t)index[i] >= N))
+          problem = "corrupt name index";
+    }
+    else
+      problem = "corrupt name index";
+  }
+
+  int32_t *components = (int32_t *)(base + H->ComponentsAt);
+  int32_t *componentSizes = (int32_t *)(base + H->ComponentSizesAt);
+
+  if (problem == NULL)  // components numbered in order of lowest vertex, sizes adding up:
+  {
+    uint64_t i;
+    int64_t  next = 0;   // next new id
+    uint64_t total = 0;
+
+    for (i = 0; i < N && problem == NULL; ++i)
+    {
+      if (components[i] < 0 || components[i] > next)
+        problem = "corrupt component table";
+      else if (components[i] == next)
+        ++next;
+    }
+    if (problem == NULL && (uint64_t)next != K)
+      problem = "corrupt component table";
+    for (i = 0; i < K && problem == NULL; ++i)
+    {
+      if (componentSizes[i] < 1)
+        problem = "corrupt component table";
+      total += (uint64_t)componentSizes[i];
+    }
+    if (problem == NULL && total != N)
+      problem = "corrupt component table";
+  }
+
+  if (problem != NULL)
+  {
+    printf("**ERROR: '%s': %s\n\n", filename, problem);
+    munmap(map, (size_t)st.st_size);
+    return NULL;
+  }
+
+  //
+  // build the graph header around the mapped arrays; the only
+  // allocations are the graph and name index headers:
+  //
+  Graph *G = (Graph *)mymalloc(sizeof(Graph));
+  NameIndex *I = (NameIndex *)mymalloc(sizeof(NameIndex));
+  if (G == NULL || I == NULL)
+  {
+    printf("\n**Error in LoadGraphSnapshot: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  if (H->IndexKind == SNAPSHOT_INDEX_PERFECT)
+  {
+    I->Slots = NULL;
+    I->Hashes = NULL;
+    I->NumSlots = 0;
+    I->Displace = index;
+    I->Perfect = indexAux;
+    I->NumBuckets = (int)S;
+  }
+  else
+  {
+    I->Slots = index;
+    I->Hashes = (unsigned int *)indexAux;
+    I->NumSlots = (int)S;
+    I->Displace = NULL;
+    I->Perfect = NULL;
+    I->NumBuckets = 0;
+  }
+
+  I->NumElements = (int)N;
+
+  G->Vertices = NULL;
+  G->EdgePool = NULL;
+  G->NamesIndex = I;
+  G->NameChars = base + H->NameCharsAt;
+  G->NameOffsets = (int *)nameOffsets;
+  G->NameCharsCapacity = nameOffsets[N];
+  G->Offsets = offsets;
+  G->Dests = (Vertex *)(base + H->DestsAt);
+  G->Weights = (int *)(base + H->WeightsAt);
+  G->Frozen = 1;  /*true*/
+  G->Symmetric = (int)H->Symmetric;
+  G->Component = (int *)components;
+  G->ComponentSizes = (int *)componentSizes;
+  G->NumComponents = (int)K;
+  G->Snapshot = map;
+  G->SnapshotSize = (long)st.st_size;
+  G->NumVertices = (int)N;
+  G->NumEdges = (int)E;
+  G->Capacity = (int)N;
+
+  return G;
+}
+
+//
+// UnmapGraphSnapshot:
+//
+// Releases the file mapping behind a graph loaded by
+// LoadGraphSnapshot; called by DeleteGraph.
+//
+void UnmapGraphSnapshot(Graph *G)
+{
+  if (G->Snapshot == NULL)
+    return;
+
+  munmap(G->Snapshot, (size_t)G->SnapshotSize);
+
+  G->Snapshot = NULL;
+  G->SnapshotSize = 0;
+}
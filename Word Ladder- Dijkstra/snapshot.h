@@ -0,0 +1,17 @@
+/*snapshot.h*/
+
+//
+// Graph snapshots:
+//
+// A frozen graph can be saved to a versioned, checksummed binary
+// file holding the vertex names, the name index, the CSR adjacency
+// and the component labels.  Loading a snapshot mmap's the file and
+// points the graph's arrays straight into it, so there is no parsing
+// and no per-vertex allocation; free the graph with DeleteGraph as
+// usual.
+//
+#define SNAPSHOT_VERSION  3
+
+int    SaveGraphSnapshot(Graph *G, char *filename);
+Graph *LoadGraphSnapshot(char *filename);
+void   UnmapGraphSnapshot(Graph *G);
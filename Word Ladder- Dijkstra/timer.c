@@ -13,28 +13,54 @@
 // Based off of code given by Prof. Joe Hummel
 // 
 
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE  // for syscall()
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <time.h>
+#include <pthread.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
 
 #include "timer.h"
 
-static clock_t myTimerStart = 0;
-static clock_t myTimerEnd = 0;
+static long long _now()  // in nanoseconds:
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+long long timer_nanos()
+{
+	return _now();
+}
+
+// each thread has its own timer:
+static _Thread_local long long myTimerStart = 0;
+static _Thread_local long long myTimerEnd = 0;
 
 void timer_start()
 {
-	myTimerStart = clock();
+	myTimerStart = _now();
 }
 
 void timer_stop()
 {
-	myTimerEnd = clock();
+	myTimerEnd = _now();
 }
 
 double timer_value()
 {
-	return (((double) myTimerEnd) - ((double) myTimerStart)) / CLOCKS_PER_SEC;
+	return (double)(myTimerEnd - myTimerStart) / 1e9;
 }
 
 void timer_stats(char* message)
@@ -44,3 +70,420 @@ void timer_stats(char* message)
 	else
 	  printf("%s%lf seconds\n", message, timer_value());
 }
+
+
+//
+// Phase timers:
+//
+// A table of phases, each identified by its name and its parent
+// phase (-1 at the top level), in the order first begun, so a
+// parent always comes before its children.  Each thread fills its
+// own table; at thread exit (via a pthread key destructor) the table
+// is merged into the global one.
+//
+#define TIMER_MAX_PHASES  64  // per table; more are not timed
+#define TIMER_MAX_DEPTH   16  // deeper nesting is not timed
+#define TIMER_COUNTERS    5   // hardware counters, see _openCounters
+
+typedef struct TimerPhase
+{
+	const char* Name;
+	int         Parent;
+	long        Calls;
+	long long   Nanos;
+	long long   Counts[TIMER_COUNTERS];  // if counted, see CounterMask
+	int         Threads;  // # of threads that ran it (global table)
+} TimerPhase;
+
+typedef struct TimerTable
+{
+	TimerPhase  Phases[TIMER_MAX_PHASES];
+	int         NumPhases;
+	int         CounterMask;   // bit c set => counter c was counted
+	int         CounterError;  // errno, if no counter could be opened
+} TimerTable;
+
+static TimerTable       g_phases;  // merged totals
+static pthread_mutex_t  g_phasesLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t    g_exitKey;
+static pthread_once_t   g_exitKeyOnce = PTHREAD_ONCE_INIT;
+
+static _Thread_local TimerTable myPhases;
+static _Thread_local int        myRegistered = 0;
+static _Thread_local int        myStack[TIMER_MAX_DEPTH];  // open phases
+static _Thread_local long long  myStarts[TIMER_MAX_DEPTH];
+static _Thread_local int        myDepth = 0;
+
+static int                      g_countersOn = 0;  /*false*/
+static _Thread_local int        myCountersTried = 0;  /*false*/
+static _Thread_local int        myNumCounters = 0;  // open, in group order:
+static _Thread_local int        myCounterFds[TIMER_COUNTERS];
+static _Thread_local int        myCounterIds[TIMER_COUNTERS];
+static _Thread_local long long  myStartCounts[TIMER_MAX_DEPTH][TIMER_COUNTERS];
+
+//
+// _findPhase:
+//
+// Returns the index of phase name under parent in T, adding it if
+// new; -1 if T is full.
+//
+static int _findPhase(TimerTable* T, int parent, const char* name)
+{
+	int i;
+
+	for (i = 0; i < T->NumPhases; ++i)
+	{
+		if (T->Phases[i].Parent == parent &&
+		    (T->Phases[i].Name == name || strcmp(T->Phases[i].Name, name) == 0))
+			return i;
+	}
+
+	if (T->NumPhases == TIMER_MAX_PHASES)
+		return -1;
+
+	i = T->NumPhases++;
+	T->Phases[i].Name = name;
+	T->Phases[i].Parent = parent;
+	T->Phases[i].Calls = 0;
+	T->Phases[i].Nanos = 0;
+	memset(T->Phases[i].Counts, 0, sizeof(T->Phases[i].Counts));
+	T->Phases[i].Threads = 0;
+
+	return i;
+}
+
+//
+// _mergePhases:
+//
+// Adds T's totals into the global table, and zeroes them; T's
+// phases are kept, since some may still be open.
+//
+static void _mergePhases(TimerTable* T)
+{
+	int map[TIMER_MAX_PHASES];  // T's index => global index
+	int i;
+
+	pthread_mutex_lock(&g_phasesLock);
+
+	g_phases.CounterMask |= T->CounterMask;
+	if (g_phases.CounterError == 0)
+		g_phases.CounterError = T->CounterError;
+
+	for (i = 0; i < T->NumPhases; ++i)
+	{
+		TimerPhase* P = &T->Phases[i];
+		int parent = (P->Parent < 0) ? -1 : map[P->Parent];
+
+		map[i] = (P->Parent >= 0 && parent < 0) ? -1 : _findPhase(&g_phases, parent, P->Name);
+
+		if (map[i] >= 0 && P->Calls > 0)
+		{
+			TimerPhase* G = &g_phases.Phases[map[i]];
+			int c;
+
+			G->Calls += P->Calls;
+			G->Nanos += P->Nanos;
+			for (c = 0; c < TIMER_COUNTERS; ++c)
+				G->Counts[c] += P->Counts[c];
+			G->Threads++;
+		}
+
+		P->Calls = 0;
+		P->Nanos = 0;
+		memset(P->Counts, 0, sizeof(P->Counts));
+	}
+
+	pthread_mutex_unlock(&g_phasesLock);
+}
+
+
+//
+// Hardware counters:
+//
+// Each thread opens its own group of counters (they count only the
+// thread that opened them), the first time it begins a phase after
+// timer_enable_counters; the group is read with one read() at each
+// timer_begin and timer_end.  A counter that can't be opened (e.g.
+// no such event on this CPU, or no PMU at all in a VM) is skipped,
+// and the rest form the group.  If the kernel had to multiplex the
+// group with other users of the PMU, the counts are scaled up by
+// the fraction of time it actually ran.
+//
+static const char* CounterNames[TIMER_COUNTERS] =
+	{ "cycles", "instrs", "L1d miss", "LLC miss", "br miss" };
+
+static void _openCounters()
+{
+	myCountersTried = 1;  /*true*/
+
+#ifdef __linux__
+	static const struct { unsigned int Type; unsigned long long Config; } events[TIMER_COUNTERS] =
+	{
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+		                      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+		{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+		                      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	};
+	int error = 0;
+	int c;
+
+	for (c = 0; c < TIMER_COUNTERS; ++c)
+	{
+		struct perf_event_attr attr;
+
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = events[c].Type;
+		attr.config = events[c].Config;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+		                   PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attr.exclude_kernel = 1;  // allowed at perf_event_paranoid 2
+		attr.exclude_hv = 1;
+
+		int leader = (myNumCounters == 0) ? -1 : myCounterFds[0];
+		int fd = (int)syscall(SYS_perf_event_open, &attr, 0 /*this thread*/, -1 /*any cpu*/, leader, 0);
+
+		if (fd < 0)
+		{
+			if (error == 0)
+				error = errno;
+			continue;
+		}
+
+		myCounterFds[myNumCounters] = fd;
+		myCounterIds[myNumCounters] = c;
+		myNumCounters++;
+		myPhases.CounterMask |= 1 << c;
+	}
+
+	if (myNumCounters == 0)
+		myPhases.CounterError = error;
+#else
+	myPhases.CounterError = ENOSYS;
+#endif
+}
+
+//
+// _readCounters:
+//
+// Reads the thread's counters into counts[], by counter #; returns
+// false (0) if the read fails, in which case counts[] is unchanged.
+//
+static int _readCounters(long long counts[TIMER_COUNTERS])
+{
+#ifdef __linux__
+	unsigned long long values[3 + TIMER_COUNTERS];  // nr, enabled, running, counts
+	int i;
+
+	if (read(myCounterFds[0], values, sizeof(values)) < (ssize_t)((3 + myNumCounters) * sizeof(values[0])))
+		return 0;  /*false*/
+
+	double scale = (values[2] > 0 && values[2] < values[1]) ? (double)values[1] / values[2] : 1.0;
+
+	for (i = 0; i < myNumCounters; ++i)
+		counts[myCounterIds[i]] = (long long)(values[3 + i] * scale);
+
+	return 1;  /*true*/
+#else
+	return 0;  /*false*/
+#endif
+}
+
+static void _closeCounters()
+{
+#ifdef __linux__
+	int i;
+
+	for (i = 0; i < myNumCounters; ++i)
+		close(myCounterFds[i]);
+#endif
+
+	myNumCounters = 0;
+}
+
+int timer_enable_counters()
+{
+	g_countersOn = 1;  /*true*/
+
+	if (!myCountersTried)
+		_openCounters();
+
+	return myNumCounters;
+}
+
+
+static void _threadExit(void* table)
+{
+	_mergePhases((TimerTable*)table);
+	_closeCounters();
+}
+
+static void _createExitKey()
+{
+	pthread_key_create(&g_exitKey, _threadExit);
+}
+
+void timer_begin(const char* name)
+{
+	if (!myRegistered)  // merge this thread's totals when it exits:
+	{
+		pthread_once(&g_exitKeyOnce, _createExitKey);
+		pthread_setspecific(g_exitKey, &myPhases);
+		myRegistered = 1;
+	}
+
+	if (myDepth < TIMER_MAX_DEPTH)
+	{
+		int parent = (myDepth == 0) ? -1 : myStack[myDepth - 1];
+
+		if (myDepth > 0 && parent < 0)  // parent not timed, nor is this:
+			myStack[myDepth] = -1;
+		else
+			myStack[myDepth] = _findPhase(&myPhases, parent, name);
+
+		if (g_countersOn && !myCountersTried)
+			_openCounters();
+
+		if (myNumCounters > 0 && myStack[myDepth] >= 0)
+			_readCounters(myStartCounts[myDepth]);
+
+		myStarts[myDepth] = _now();
+	}
+
+	myDepth++;
+}
+
+void timer_end()
+{
+	if (myDepth == 0)  // unmatched:
+		return;
+
+	myDepth--;
+
+	if (myDepth < TIMER_MAX_DEPTH && myStack[myDepth] >= 0)
+	{
+		TimerPhase* P = &myPhases.Phases[myStack[myDepth]];
+
+		P->Calls++;
+		P->Nanos += _now() - myStarts[myDepth];
+
+		long long counts[TIMER_COUNTERS];
+		int c;
+
+		if (myNumCounters > 0 && _readCounters(counts))
+		{
+			for (c = 0; c < TIMER_COUNTERS; ++c)
+			{
+				if (myPhases.CounterMask & (1 << c))
+					P->Counts[c] += counts[c] - myStartCounts[myDepth][c];
+			}
+		}
+	}
+}
+
+//
+// _printPhases:
+//
+// Prints the children of parent, and recursively theirs, indented
+// by depth.
+//
+static void _printPhases(FILE* out, int parent, int depth)
+{
+	int i;
+
+	for (i = 0; i < g_phases.NumPhases; ++i)
+	{
+		TimerPhase* P = &g_phases.Phases[i];
+
+		if (P->Parent != parent)
+			continue;
+
+		fprintf(out, "   %*s%-*s %10ld %8d %12.6f %12.4f\n",
+		  2 * depth, "", 28 - 2 * depth, P->Name, P->Calls, P->Threads,
+		  P->Nanos / 1e9, (P->Calls > 0) ? P->Nanos / 1e6 / P->Calls : 0.0);
+
+		_printPhases(out, i, depth + 1);
+	}
+}
+
+//
+// _printCounters:
+//
+// Same, with each phase's counts per call; a counter that was never
+// counted prints as "-".
+//
+static void _printCounters(FILE* out, int parent, int depth)
+{
+	int i, c;
+
+	for (i = 0; i < g_phases.NumPhases; ++i)
+	{
+		TimerPhase* P = &g_phases.Phases[i];
+		long calls = (P->Calls > 0) ? P->Calls : 1;
+
+		if (P->Parent != parent)
+			continue;
+
+		fprintf(out, "   %*s%-*s", 2 * depth, "", 28 - 2 * depth, P->Name);
+
+		for (c = 0; c < TIMER_COUNTERS; ++c)
+		{
+			if (g_phases.CounterMask & (1 << c))
+				fprintf(out, " %12.0f", (double)P->Counts[c] / calls);
+			else
+				fprintf(out, " %12s", "-");
+
+			if (c == 1)  // instructions per cycle, after the two:
+			{
+				if ((g_phases.CounterMask & 3) == 3 && P->Counts[0] > 0)
+					fprintf(out, " %6.2f", (double)P->Counts[1] / P->Counts[0]);
+				else
+					fprintf(out, " %6s", "-");
+			}
+		}
+
+		fprintf(out, "\n");
+
+		_printCounters(out, i, depth + 1);
+	}
+}
+
+void timer_summary(FILE* out)
+{
+	_mergePhases(&myPhases);  // the calling thread's, so far
+
+	pthread_mutex_lock(&g_phasesLock);
+
+	fprintf(out, "** Phase times (wall clock, summed over threads):\n");
+	fprintf(out, "   %-28s %10s %8s %12s %12s\n", "phase", "calls", "threads", "total (s)", "avg (ms)");
+	_printPhases(out, -1, 0);
+
+	if (g_countersOn && g_phases.CounterMask == 0)
+	{
+		fprintf(out, "** Phase counters: none available (%s)\n", strerror(g_phases.CounterError));
+		if (g_phases.CounterError == EACCES || g_phases.CounterError == EPERM)
+			fprintf(out, "   (see /proc/sys/kernel/perf_event_paranoid)\n");
+	}
+	else if (g_countersOn)
+	{
+		int c;
+
+		fprintf(out, "** Phase counters (user space, per call, summed over threads):\n");
+		fprintf(out, "   %-28s", "phase");
+		for (c = 0; c < TIMER_COUNTERS; ++c)
+		{
+			fprintf(out, " %12s", CounterNames[c]);
+			if (c == 1)
+				fprintf(out, " %6s", "IPC");
+		}
+		fprintf(out, "\n");
+		_printCounters(out, -1, 0);
+	}
+
+	pthread_mutex_unlock(&g_phasesLock);
+}
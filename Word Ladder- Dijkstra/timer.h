@@ -12,8 +12,37 @@
 // CS251, Fall 2016
 // Based off of code given by Prof. Joe Hummel
 // 
+// Times are wall-clock times, from CLOCK_MONOTONIC.
+//
 
 void timer_start();
 void timer_stop();
 double timer_value();
 void timer_stats(char* message);
+long long timer_nanos();  // current time, in nanoseconds
+
+//
+// Phase timers:  timer_begin(name) ... timer_end() times a named
+// phase, and phases begun inside another phase are nested under it.
+// Each thread keeps its own totals (calls and time per phase), which
+// are added to the program-wide totals when the thread exits.
+// timer_summary prints the totals, as a tree of phases, including
+// the calling thread's but not those of threads still running.
+// Names should be string literals (or otherwise outlive the
+// program).
+//
+void timer_begin(const char* name);
+void timer_end();
+void timer_summary(FILE* out);
+
+//
+// Hardware counters:  once timer_enable_counters() is called, each
+// phase also counts CPU cycles, instructions, L1 data cache and
+// last-level cache read misses, and branch mispredictions (in user
+// space, via Linux's perf_event_open), and timer_summary prints
+// them per call.  Counters the hardware, kernel or permissions
+// don't allow are left out, and if none are, only times are kept.
+// Call it before starting any threads; returns the # of counters
+// open in the calling thread.
+//
+int timer_enable_counters();
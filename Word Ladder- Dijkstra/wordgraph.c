@@ -0,0 +1,1020 @@
+/*wordgraph.c*/
+
+//
+// Word graph construction:  for each word, add edges to/from the
+// words that differ by exactly one letter.
+//
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "nameindex.h"
+#include "workspace.h"
+#include "graph.h"
+#include "wordgraph.h"
+#include "mymem.h"
+#include "timer.h"
+
+
+//
+// Read_and_AddWords:
+//
+// Creates a graph with one vertex per line (word) of the given file;
+// no edges are added.  Exits the program if the file is not found.
+//
+// The whole file is read at once, and its lines are turned into
+// '\0'-terminated words in place, so the words can be added with
+// one AddVertices call:  the graph is sized for all of them up
+// front, and a sorted dictionary is indexed in one pass.
+//
+Graph *Read_and_AddWords(char *filename)
+{
+  FILE  *input;
+
+  input = fopen(filename, "r");
+  if (input == NULL)
+  {
+    printf("**ERROR: '%s' not found\n\n", filename);
+    exit(-1);
+  }
+
+  //
+  // (1) input the whole file:
+  //
+  timer_begin("read file");
+
+  fseek(input, 0, SEEK_END);
+  long size = ftell(input);
+  rewind(input);
+
+  if (size < 0)
+    size = 0;
+
+  char *text = (char *)mymalloc((size + 1) * sizeof(char));
+  if (text == NULL)
+  {
+    printf("\n**Error in Read_and_AddWords: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  size_t length = fread(text, sizeof(char), size, input);
+
+  text[length] = '\0';  // so the last line ends, EOL or not
+  fclose(input);
+
+  //
+  // (2) one word per line:  strip the EOL(s) char, and move the word
+  // down to follow the previous one; a word is never longer than its
+  // line, so this can be done in place:
+  //
+  char *end = text + length;
+  char *from = text;
+  char *to = text;
+  int   numWords = 0;
+
+  while (from < end)
+  {
+    char *eol = (char *)memchr(from, '\n', end - from);
+
+    if (eol == NULL)  // last line has no EOL:
+      eol = end;
+
+    size_t n = strcspn(from, "\r\n");  // stops at eol, if not before
+
+    memmove(to, from, n);
+    to[n] = '\0';
+    to += n + 1;
+    numWords++;
+
+    from = eol + 1;
+  }
+
+  timer_end();
+
+  //
+  // (3) insert each word as a vertex:
+  //
+  timer_begin("add vertices");
+
+  Graph *G = CreateGraph(numWords > 0 ? numWords : 1);
+
+  if (AddVertices(G, text, numWords) < 0)
+  {
+    printf("**Error: AddVertices failed?!\n\n");
+    exit(-1);
+  }
+
+  timer_end();
+
+  //
+  // done:
+  //
+  myfree(text);
+
+  return G;
+}
+
+//
+// AddEdges:
+//
+// Adds all one-letter-difference edges to G using the given
+// engine, EDGES_BY_PROBING or EDGES_BY_BUCKETS, and the given
+// # of threads.
+//
+void AddEdges(Graph *G, int engine, int numThreads)
+{
+  if (engine == EDGES_BY_PROBING)
+    AddEdgesByProbing(G, numThreads);
+  else
+    AddEdgesByBuckets(G, numThreads);
+}
+
+
+// #####################################################
+//
+// Edge workers:
+//
+// Finding a word's neighbors only reads the graph, so the vertices
+// are split into one contiguous range per thread.  Each worker buffers
+// the edges of its range, in the same order the serial build would
+// add them; once all workers are done, the buffers are added to the
+// graph in worker order, so the graph is identical to the serial one.
+//
+// Workers never allocate:  if a worker's buffer fills up, it drops
+// the row it was working on and stops; the main thread then doubles
+// the buffer and runs the worker again from that row.
+//
+typedef struct EdgeBuild
+{
+  Graph  *G;
+  int     Engine;
+  int    *WordStart;  // bucket engine tables, see below:
+  int    *EntryVertex;
+  int    *Next;
+  int    *Bucket;
+  int    *Table;
+} EdgeBuild;
+
+typedef struct EdgeWorker
+{
+  EdgeBuild *B;
+  Vertex     First;     // rows First..Last-1 belong to this worker
+  Vertex     Last;
+  Vertex     Row;       // next row to do, Last when done
+  int        Direct;    // serial build: add edges to graph right away
+  int        Launched;  // thread running in this round?
+  Vertex    *Src;       // buffered edges Src[i] -> Dest[i]
+  Vertex    *Dest;
+  int        NumEdges;
+  int        Capacity;
+  char      *Temp;      // probing engine: scratch copy of word
+} EdgeWorker;
+
+//
+// _emit:
+//
+// Adds edge v -> u to the graph (serial build) or to the worker's
+// buffer.  Returns false (0) if the buffer is full.
+//
+static int _emit(EdgeWorker *W, Vertex v, Vertex u)
+{
+  if (W->Direct)
+  {
+    if (!AddEdge(W->B->G, v, u, 1))
+    {
+      printf("**Error: AddEdge failed?!\n\n");
+      exit(-1);
+    }
+
+    return 1;  /*true*/
+  }
+
+  if (W->NumEdges == W->Capacity)  // full:
+    return 0;  /*false*/
+
+  W->Src[W->NumEdges] = v;
+  W->Dest[W->NumEdges] = u;
+  W->NumEdges++;
+
+  return 1;  /*true*/
+}
+
+static int _probeRow(EdgeWorker *W, Vertex v);
+static int _bucketRow(EdgeWorker *W, Vertex v);
+
+//
+// _runWorker:
+//
+// Thread function:  finds the edges of rows Row..Last-1, stopping
+// early if the buffer fills up.
+//
+static void *_runWorker(void *arg)
+{
+  EdgeWorker *W = (EdgeWorker *)arg;
+
+  timer_begin("find edges");
+
+  for (; W->Row < W->Last; W->Row++)
+  {
+    int  mark = W->NumEdges;
+    int  ok;
+
+    if (W->B->Engine == EDGES_BY_PROBING)
+      ok = _probeRow(W, W->Row);
+    else
+      ok = _bucketRow(W, W->Row);
+
+    if (!ok)  // buffer full, drop partial row:
+    {
+      W->NumEdges = mark;
+      break;
+    }
+  }
+
+  timer_end();
+
+  return NULL;
+}
+
+//
+// _growWorker:
+//
+// Doubles the capacity of the worker's edge buffer.
+//
+static void _growWorker(EdgeWorker *W)
+{
+  int     N = 2 * W->Capacity;
+  Vertex *src = (Vertex *)mymalloc(N * sizeof(Vertex));
+  Vertex *dest = (Vertex *)mymalloc(N * sizeof(Vertex));
+  if (src == NULL || dest == NULL)
+  {
+    printf("\n**Error in AddEdges: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  memcpy(src, W->Src, W->NumEdges * sizeof(Vertex));
+  memcpy(dest, W->Dest, W->NumEdges * sizeof(Vertex));
+
+  myfree(W->Src);
+  myfree(W->Dest);
+
+  W->Src = src;
+  W->Dest = dest;
+  W->Capacity = N;
+}
+
+//
+// _buildEdges:
+//
+// Runs the workers over all vertices using numThreads threads, then
+// adds the buffered edges to the graph.  With 1 thread, the edges are
+// added directly, as they are found.
+//
+static void _buildEdges(EdgeBuild *B, int numThreads)
+{
+  Graph *G = B->G;
+  int    maxLen = 0;
+  int    v, t;
+
+  for (v = 0; v < G->NumVertices; ++v)  // size of probing scratch word:
+  {
+    int len = G->NameOffsets[v + 1] - G->NameOffsets[v];
+
+    if (len > maxLen)
+      maxLen = len;
+  }
+
+  if (numThreads > G->NumVertices)
+    numThreads = G->NumVertices;
+
+  if (numThreads <= 1)  // serial build:
+  {
+    EdgeWorker W;
+
+    W.B = B;
+    W.First = 0;
+    W.Last = G->NumVertices;
+    W.Row = 0;
+    W.Direct = 1;  /*true*/
+    W.Launched = 0;  /*false*/
+    W.Src = NULL;
+    W.Dest = NULL;
+    W.NumEdges = 0;
+    W.Capacity = 0;
+    W.Temp = (char *)mymalloc((maxLen + 1) * sizeof(char));
+
+    _runWorker(&W);
+
+    myfree(W.Temp);
+    return;
+  }
+
+  //
+  // one worker per thread, each with an equal share of the rows:
+  //
+  EdgeWorker *workers = (EdgeWorker *)mymalloc(numThreads * sizeof(EdgeWorker));
+  pthread_t  *threads = (pthread_t *)mymalloc(numThreads * sizeof(pthread_t));
+  if (workers == NULL || threads == NULL)
+  {
+    printf("\n**Error in AddEdges: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  for (t = 0; t < numThreads; ++t)
+  {
+    EdgeWorker *W = &workers[t];
+
+    W->B = B;
+    W->First = (int)(((long long)G->NumVertices * t) / numThreads);
+    W->Last = (int)(((long long)G->NumVertices * (t + 1)) / numThreads);
+    W->Row = W->First;
+    W->Direct = 0;  /*false*/
+    W->NumEdges = 0;
+    W->Capacity = 4 * (W->Last - W->First) + 16;  // a guess, grows as needed:
+    W->Src = (Vertex *)mymalloc(W->Capacity * sizeof(Vertex));
+    W->Dest = (Vertex *)mymalloc(W->Capacity * sizeof(Vertex));
+    W->Temp = (char *)mymalloc((maxLen + 1) * sizeof(char));
+    if (W->Src == NULL || W->Dest == NULL || W->Temp == NULL)
+    {
+      printf("\n**Error in AddEdges: malloc failed to allocate\n\n");
+      exit(-1);
+    }
+  }
+
+  //
+  // run the workers until every one has finished its rows; after
+  // the first round, unfinished workers ran out of buffer:
+  //
+  int  round = 0;
+  int  unfinished = numThreads;
+
+  while (unfinished > 0)
+  {
+    for (t = 0; t < numThreads; ++t)
+    {
+      EdgeWorker *W = &workers[t];
+
+      W->Launched = 0;  /*false*/
+
+      if (W->Row == W->Last)  // done:
+        continue;
+
+      if (round > 0)
+        _growWorker(W);
+
+      if (pthread_create(&threads[t], NULL, _runWorker, W) != 0)
+      {
+        printf("\n**Error in AddEdges: unable to create thread\n\n");
+        exit(-1);
+      }
+
+      W->Launched = 1;  /*true*/
+    }
+
+    unfinished = 0;
+
+    for (t = 0; t < numThreads; ++t)
+    {
+      EdgeWorker *W = &workers[t];
+
+      if (!W->Launched)
+        continue;
+
+      pthread_join(threads[t], NULL);
+
+      if (W->Row < W->Last)
+        unfinished++;
+    }
+
+    round++;
+  }
+
+  //
+  // merge:  add the buffered edges in worker order:
+  //
+  timer_begin("merge edges");
+
+  for (t = 0; t < numThreads; ++t)
+  {
+    EdgeWorker *W = &workers[t];
+    int  i;
+
+    for (i = 0; i < W->NumEdges; ++i)
+    {
+      if (!AddEdge(G, W->Src[i], W->Dest[i], 1))
+      {
+        printf("**Error: AddEdge failed?!\n\n");
+        exit(-1);
+      }
+    }
+
+    myfree(W->Src);
+    myfree(W->Dest);
+    myfree(W->Temp);
+  }
+
+  timer_end();
+
+  myfree(threads);
+  myfree(workers);
+}
+
+
+//
+// AddEdgesByProbing:
+//
+// For each word, generates all possible words that differ by one
+// letter ('a'..'z' at each position), and adds an edge from the
+// word to each candidate that exists in the graph.  This costs
+// 26 x L name lookups per word.
+//
+void AddEdgesByProbing(Graph *G, int numThreads)
+{
+  EdgeBuild B;
+
+  B.G = G;
+  B.Engine = EDGES_BY_PROBING;
+  B.WordStart = NULL;  // no buckets:
+  B.EntryVertex = NULL;
+  B.Next = NULL;
+  B.Bucket = NULL;
+  B.Table = NULL;
+
+  _buildEdges(&B, numThreads);
+}
+
+//
+// _probeRow:
+//
+// Emits the edges out of v found by probing; returns false (0) if
+// the worker's buffer filled up.
+//
+static int _probeRow(EdgeWorker *W, Vertex v)
+{
+  Graph *G = W->B->G;
+  char  *word = G->NameChars + G->NameOffsets[v];
+  char  *temp = W->Temp;
+
+  int  i;
+  for (i = 0; i < (int)strlen(word); ++i)
+  {
+    strcpy(temp, word);
+
+    char  c = 'a';
+    while (c <= 'z')
+    {
+      temp[i] = c;  // change one letter:
+
+      int v2 = Name2Vertex(G, temp);
+      if (v2 >= 0 && v2 != v)  // dest exists, add edge:
+      {
+        if (!_emit(W, v, v2))
+          return 0;  /*false*/
+      }//if
+
+      ++c;
+    }
+  }
+
+  return 1;  /*true*/
+}
+
+
+// #####################################################
+//
+// Wildcard buckets:
+//
+// Every (word, position) pair is an "entry": entry e = WordStart[v] + i
+// denotes word v with letter i replaced by a wildcard, e.g. "cat" at
+// position 1 => "c_t".  Entries with the same pattern form a bucket;
+// the hash table maps each pattern to the first entry of its bucket,
+// and the remaining entries are chained through Next[].
+//
+
+//
+// PatternHash:
+//
+// FNV-1a hash of word with position i treated as a wildcard.
+//
+static unsigned int PatternHash(char *word, int len, int i)
+{
+  unsigned int h = 2166136261u;
+  int  k;
+
+  for (k = 0; k < len; ++k)
+  {
+    if (k != i)
+      h ^= (unsigned char)word[k];
+
+    h *= 16777619u;
+  }
+
+  h ^= (unsigned int)i;  // "c_t" and "ca_" must differ:
+  h *= 16777619u;
+
+  return h;
+}
+
+//
+// SamePattern:
+//
+// Returns true (non-zero) if the two words, both of length len, are
+// equal everywhere except possibly at position i.
+//
+static int SamePattern(char *word1, char *word2, int len, int i)
+{
+  int  k;
+
+  for (k = 0; k < len; ++k)
+  {
+    if (k != i && word1[k] != word2[k])
+      return 0;  /*false*/
+  }
+
+  return 1;  /*true*/
+}
+
+// #####################################################
+//
+// Filling the buckets:
+//
+// The hash table is split into partitions, chosen by the top bits of
+// a pattern's hash, each a separate open-addressing region of its own
+// (power of 2) size, so no probe sequence crosses from one partition
+// into another.  The fill then runs in three parallel steps, with a
+// join between each:
+//
+//   (a) hash:     each worker hashes the entries of its range of
+//                 words, and counts them by partition
+//   (b) scatter:  the counts are prefix-summed in (partition,
+//                 worker) order, and each worker copies its entries
+//                 to their partition's part of Order[]
+//   (c) place:    each worker inserts the entries of its partitions
+//                 into their regions of the table
+//
+// Within a partition, the entries are placed in ascending order, as
+// the serial fill does, so every bucket's chain is the same for any
+// # of threads.  With 1 thread there is one partition, the whole
+// table, and no scatter.
+//
+#define FILL_PARTITIONS_PER_THREAD  8  // so (c) balances across threads
+
+typedef struct FillBuild
+{
+  Graph        *G;
+  int          *WordStart;    // as in EdgeBuild:
+  int          *EntryVertex;
+  int          *Next;
+  int          *Bucket;
+  int           NumEntries;
+  unsigned int *EntryHash;    // PatternHash() of each entry
+  int          *Order;        // entries, grouped by partition
+  int           NumParts;     // # of partitions, a power of 2
+  int           PartBits;     // log2(NumParts)
+  int          *PartCounts;   // [worker * NumParts + p]:  # of entries, then cursor
+  int          *PartStart;    // partition p's entries are Order[PartStart[p] .. PartStart[p+1]-1]
+  int          *RegionStart;  // partition p's slots are Table[RegionStart[p] .. RegionStart[p+1]-1]
+  int          *Table;        // first entry of each bucket, -1 => empty slot
+  unsigned int *TableHash;    // PatternHash() of each slot's pattern
+  int           NumWorkers;
+} FillBuild;
+
+typedef struct FillWorker
+{
+  FillBuild *F;
+  int        Index;
+  Vertex     First;  // words First..Last-1 belong to this worker in (a), (b)
+  Vertex     Last;
+  int        Step;   // 'a', 'b' or 'c'
+} FillWorker;
+
+static int _partitionOf(FillBuild *F, unsigned int h)
+{
+  return (F->PartBits == 0) ? 0 : (int)(h >> (32 - F->PartBits));
+}
+
+//
+// _hashEntries:
+//
+// Step (a), for the worker's words.
+//
+static void _hashEntries(FillWorker *W)
+{
+  FillBuild *F = W->F;
+  Graph     *G = F->G;
+  int       *counts = F->PartCounts + W->Index * F->NumParts;
+  int        v, i;
+
+  for (v = W->First; v < W->Last; ++v)
+  {
+    char *word = G->NameChars + G->NameOffsets[v];
+    int   len = F->WordStart[v + 1] - F->WordStart[v];
+
+    for (i = 0; i < len; ++i)
+    {
+      int           e = F->WordStart[v] + i;
+      unsigned int  h = PatternHash(word, len, i);
+
+      F->EntryVertex[e] = v;
+      F->EntryHash[e] = h;
+      counts[_partitionOf(F, h)]++;
+    }
+  }
+}
+
+//
+// _scatterEntries:
+//
+// Step (b), for the worker's words; PartCounts holds the worker's
+// next position in Order[] for each partition.
+//
+static void _scatterEntries(FillWorker *W)
+{
+  FillBuild *F = W->F;
+  int       *cursor = F->PartCounts + W->Index * F->NumParts;
+  int        e;
+
+  for (e = F->WordStart[W->First]; e < F->WordStart[W->Last]; ++e)
+    F->Order[cursor[_partitionOf(F, F->EntryHash[e])]++] = e;
+}
+
+//
+// _placeEntries:
+//
+// Step (c), for partitions Index, Index + NumWorkers, ...:  empties
+// the partition's region of the table, then inserts each entry into
+// the bucket for its pattern, probing only within the region.
+//
+static void _placeEntries(FillWorker *W)
+{
+  FillBuild *F = W->F;
+  Graph     *G = F->G;
+  int        p, k;
+
+  for (p = W->Index; p < F->NumParts; p += F->NumWorkers)
+  {
+    int           base = F->RegionStart[p];
+    unsigned int  mask = (unsigned int)(F->RegionStart[p + 1] - base - 1);
+
+    for (k = base; k < F->RegionStart[p + 1]; ++k)  // all buckets empty:
+      F->Table[k] = -1;
+
+    for (k = F->PartStart[p]; k < F->PartStart[p + 1]; ++k)
+    {
+      int           e = (F->Order != NULL) ? F->Order[k] : k;
+      int           v = F->EntryVertex[e];
+      int           len = F->WordStart[v + 1] - F->WordStart[v];
+      int           i = e - F->WordStart[v];
+      char         *word = G->NameChars + G->NameOffsets[v];
+      unsigned int  h = F->EntryHash[e];
+      unsigned int  slot = h & mask;
+
+      //
+      // linear probing until we find this pattern's bucket, or an
+      // empty slot:
+      //
+      while (F->Table[base + slot] != -1)
+      {
+        int  head = F->Table[base + slot];
+        int  headV = F->EntryVertex[head];
+
+        if (F->TableHash[base + slot] == h &&
+            F->WordStart[headV + 1] - F->WordStart[headV] == len &&
+            head - F->WordStart[headV] == i &&
+            SamePattern(word, G->NameChars + G->NameOffsets[headV], len, i))
+          break;  // found bucket:
+
+        slot = (slot + 1) & mask;
+      }
+
+      F->Next[e] = F->Table[base + slot];  // link in at front of bucket:
+      F->Table[base + slot] = e;
+      F->TableHash[base + slot] = h;
+      F->Bucket[e] = base + (int)slot;
+    }
+  }
+}
+
+//
+// _runFillWorker:
+//
+// Thread function:  runs the worker's current step.
+//
+static void *_runFillWorker(void *arg)
+{
+  FillWorker *W = (FillWorker *)arg;
+
+  if (W->Step == 'a')
+  {
+    timer_begin("hash patterns");
+    _hashEntries(W);
+    timer_end();
+  }
+  else if (W->Step == 'b')
+  {
+    timer_begin("scatter patterns");
+    _scatterEntries(W);
+    timer_end();
+  }
+  else
+  {
+    timer_begin("place patterns");
+    _placeEntries(W);
+    timer_end();
+  }
+
+  return NULL;
+}
+
+//
+// _runFillStep:
+//
+// Runs the given step on every worker, on its own thread, and waits
+// for all of them; with 1 worker, runs it directly.
+//
+static void _runFillStep(FillWorker *workers, pthread_t *threads, int numWorkers, int step)
+{
+  int  t;
+
+  for (t = 0; t < numWorkers; ++t)
+    workers[t].Step = step;
+
+  if (numWorkers == 1)  // no need for a thread:
+  {
+    _runFillWorker(&workers[0]);
+    return;
+  }
+
+  for (t = 0; t < numWorkers; ++t)
+  {
+    if (pthread_create(&threads[t], NULL, _runFillWorker, &workers[t]) != 0)
+    {
+      printf("\n**Error in AddEdges: unable to create thread\n\n");
+      exit(-1);
+    }
+  }
+
+  for (t = 0; t < numWorkers; ++t)
+    pthread_join(threads[t], NULL);
+}
+
+//
+// _fillBuckets:
+//
+// Fills F's EntryVertex, Next and Bucket arrays using numThreads
+// threads, allocating the hash table (F->Table and F->TableHash,
+// which the caller frees).
+//
+static void _fillBuckets(FillBuild *F, int numThreads)
+{
+  int  N = F->G->NumVertices;
+  int  t, p;
+
+  if (numThreads > N)
+    numThreads = N;
+  if (numThreads < 1)
+    numThreads = 1;
+
+  F->NumWorkers = numThreads;
+  F->NumParts = 1;
+  F->PartBits = 0;
+
+  if (numThreads > 1)
+  {
+    while (F->NumParts < FILL_PARTITIONS_PER_THREAD * numThreads)
+    {
+      F->NumParts *= 2;
+      F->PartBits++;
+    }
+  }
+
+  F->EntryHash = (unsigned int *)mymalloc(F->NumEntries * sizeof(unsigned int));
+  F->Order = (numThreads > 1) ? (int *)mymalloc(F->NumEntries * sizeof(int)) : NULL;
+  F->PartCounts = (int *)mymalloc(numThreads * F->NumParts * sizeof(int));
+  F->PartStart = (int *)mymalloc((F->NumParts + 1) * sizeof(int));
+  F->RegionStart = (int *)mymalloc((F->NumParts + 1) * sizeof(int));
+
+  FillWorker *workers = (FillWorker *)mymalloc(numThreads * sizeof(FillWorker));
+  pthread_t  *threads = (pthread_t *)mymalloc(numThreads * sizeof(pthread_t));
+
+  if (F->EntryHash == NULL || (numThreads > 1 && F->Order == NULL) || F->PartCounts == NULL ||
+      F->PartStart == NULL || F->RegionStart == NULL || workers == NULL || threads == NULL)
+  {
+    printf("\n**Error in AddEdgesByBuckets: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  memset(F->PartCounts, 0, numThreads * F->NumParts * sizeof(int));
+
+  for (t = 0; t < numThreads; ++t)
+  {
+    workers[t].F = F;
+    workers[t].Index = t;
+    workers[t].First = (int)(((long long)N * t) / numThreads);
+    workers[t].Last = (int)(((long long)N * (t + 1)) / numThreads);
+  }
+
+  //
+  // (a) hash and count, then size each partition's region from its
+  // count, at most half full, and turn the counts into cursors:
+  //
+  _runFillStep(workers, threads, numThreads, 'a');
+
+  int  numSlots = 0;
+  int  position = 0;
+
+  for (p = 0; p < F->NumParts; ++p)
+  {
+    int  count = 0;
+    int  size = 1;
+
+    F->PartStart[p] = position;
+
+    for (t = 0; t < numThreads; ++t)
+    {
+      int  n = F->PartCounts[t * F->NumParts + p];
+
+      F->PartCounts[t * F->NumParts + p] = position;
+      position += n;
+      count += n;
+    }
+
+    while (size < 2 * count)
+      size *= 2;
+
+    F->RegionStart[p] = numSlots;
+    numSlots += size;
+  }
+
+  F->PartStart[F->NumParts] = position;
+  F->RegionStart[F->NumParts] = numSlots;
+
+  F->Table = (int *)mymalloc(numSlots * sizeof(int));
+  F->TableHash = (unsigned int *)mymalloc(numSlots * sizeof(unsigned int));
+  if (F->Table == NULL || F->TableHash == NULL)
+  {
+    printf("\n**Error in AddEdgesByBuckets: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  //
+  // (b) group by partition, unless there's just one; (c) place:
+  //
+  if (F->NumParts > 1)
+    _runFillStep(workers, threads, numThreads, 'b');
+
+  _runFillStep(workers, threads, numThreads, 'c');
+
+  //
+  // done:
+  //
+  myfree(threads);
+  myfree(workers);
+  myfree(F->RegionStart);
+  myfree(F->PartStart);
+  myfree(F->PartCounts);
+  if (F->Order != NULL)
+    myfree(F->Order);
+  myfree(F->EntryHash);
+}
+
+//
+// AddEdgesByBuckets:
+//
+// Produces the same edges as AddEdgesByProbing(): an edge v -> u is
+// added when u differs from v at exactly one position i, and u's
+// letter at i is in 'a'..'z' (the probing engine only substitutes
+// lowercase letters).  Words are assumed to be distinct.  Both
+// filling the buckets and finding each word's neighbors in them are
+// split across numThreads threads.
+//
+void AddEdgesByBuckets(Graph *G, int numThreads)
+{
+  int  N = G->NumVertices;
+  int  v;
+
+  //
+  // number the entries: word v owns entries WordStart[v] .. WordStart[v+1]-1
+  //
+  int *wordStart = (int *)mymalloc((N + 1) * sizeof(int));
+  if (wordStart == NULL)
+  {
+    printf("\n**Error in AddEdgesByBuckets: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  int  numEntries = 0;
+
+  for (v = 0; v < N; ++v)
+  {
+    wordStart[v] = numEntries;
+    numEntries += G->NameOffsets[v + 1] - G->NameOffsets[v] - 1;  // strlen:
+  }
+
+  wordStart[N] = numEntries;
+
+  if (numEntries == 0)  // nothing to connect:
+  {
+    myfree(wordStart);
+    return;
+  }
+
+  //
+  // allocate per-entry arrays; the hash table is sized once the
+  // entries are counted by partition (see _fillBuckets):
+  //
+  int          *entryVertex = (int *)mymalloc(numEntries * sizeof(int));
+  int          *next = (int *)mymalloc(numEntries * sizeof(int));
+  int          *bucket = (int *)mymalloc(numEntries * sizeof(int));
+
+  if (entryVertex == NULL || next == NULL || bucket == NULL)
+  {
+    printf("\n**Error in AddEdgesByBuckets: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  //
+  // (1) insert every entry into the bucket for its pattern:
+  //
+  FillBuild F;
+
+  F.G = G;
+  F.WordStart = wordStart;
+  F.EntryVertex = entryVertex;
+  F.Next = next;
+  F.Bucket = bucket;
+  F.NumEntries = numEntries;
+
+  timer_begin("fill buckets");
+  _fillBuckets(&F, numThreads);
+  timer_end();
+
+  int          *table = F.Table;
+  unsigned int *tableHash = F.TableHash;
+
+  //
+  // (2) now each word's neighbors are the other members of its
+  // buckets, one bucket per letter position:
+  //
+  EdgeBuild B;
+
+  B.G = G;
+  B.Engine = EDGES_BY_BUCKETS;
+  B.WordStart = wordStart;
+  B.EntryVertex = entryVertex;
+  B.Next = next;
+  B.Bucket = bucket;
+  B.Table = table;
+
+  _buildEdges(&B, numThreads);
+
+  //
+  // done:
+  //
+  myfree(tableHash);
+  myfree(table);
+  myfree(bucket);
+  myfree(next);
+  myfree(entryVertex);
+  myfree(wordStart);
+}
+
+//
+// _bucketRow:
+//
+// Emits the edges out of v found in its buckets; returns false (0)
+// if the worker's buffer filled up.
+//
+static int _bucketRow(EdgeWorker *W, Vertex v)
+{
+  EdgeBuild *B = W->B;
+  Graph     *G = B->G;
+  int        len = B->WordStart[v + 1] - B->WordStart[v];
+  int        i;
+
+  for (i = 0; i < len; ++i)
+  {
+    int  e = B->WordStart[v] + i;
+    int  other;
+
+    for (other = B->Table[B->Bucket[e]]; other != -1; other = B->Next[other])
+    {
+      int   u = B->EntryVertex[other];
+      char  c = G->NameChars[G->NameOffsets[u] + i];
+
+      if (u != v && c >= 'a' && c <= 'z')
+      {
+        if (!_emit(W, v, u))
+          return 0;  /*false*/
+      }
+    }
+  }
+
+  return 1;  /*true*/
+}
@@ -0,0 +1,26 @@
+/*wordgraph.h*/
+
+//
+// Word graph construction:  Read_and_AddWords adds a vertex for each
+// word of a dictionary file, then AddEdges adds an edge between every
+// pair of words that differ by exactly one letter.  Two engines are
+// available; they produce the same graph:
+//
+//   EDGES_BY_PROBING:  the original approach, substitutes 'a'..'z'
+//     at every position of every word and looks up each candidate
+//     via Name2Vertex().  Kept as a reference for benchmarking.
+//
+//   EDGES_BY_BUCKETS:  groups words by wildcard pattern (e.g. "c_t")
+//     in a hash table, so a word's neighbors are found by scanning
+//     one bucket per letter position.
+//
+// Either engine can split the work across a # of threads; the
+// resulting graph is the same as with 1 thread.
+//
+#define EDGES_BY_PROBING  0
+#define EDGES_BY_BUCKETS  1
+
+Graph *Read_and_AddWords(char *filename);
+void AddEdges(Graph *G, int engine, int numThreads);
+void AddEdgesByProbing(Graph *G, int numThreads);
+void AddEdgesByBuckets(Graph *G, int numThreads);
@@ -0,0 +1,144 @@
+/*workspace.c*/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "stack.h"
+#include "pqueue.h"
+#include "workspace.h"
+#include "mymem.h"
+
+
+// #####################################################
+//
+// Search workspace:
+//
+
+//
+// CreateSearchWorkspace:
+//
+// Creates a workspace for searching graphs of up to N vertices.
+//
+SearchWorkspace *CreateSearchWorkspace(int N)
+{
+  SearchWorkspace *W;
+  int              size;
+  int              i;
+
+  if (N < 0)
+  {
+    printf("\n**Error in CreateSearchWorkspace invalid parameter N (%d)\n\n", N);
+    return NULL;
+  }
+
+  size = (N > 0) ? N : 1;  // an empty graph still gets a usable workspace:
+
+  W = (SearchWorkspace *)mymalloc(sizeof(SearchWorkspace));
+  if (W == NULL)
+  {
+    printf("\n**Error in CreateSearchWorkspace: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  W->Stamp = (unsigned int *)mymalloc(size * sizeof(unsigned int));
+  W->Distance = (int *)mymalloc(size * sizeof(int));
+  W->Predecessor = (int *)mymalloc(size * sizeof(int));
+  W->Distance2 = (int *)mymalloc(size * sizeof(int));
+  W->Predecessor2 = (int *)mymalloc(size * sizeof(int));
+  W->Order = (int *)mymalloc(size * sizeof(int));
+  W->Order2 = (int *)mymalloc(size * sizeof(int));
+  if (W->Stamp == NULL || W->Distance == NULL || W->Predecessor == NULL ||
+      W->Distance2 == NULL || W->Predecessor2 == NULL || W->Order == NULL ||
+      W->Order2 == NULL)
+  {
+    printf("\n**Error in CreateSearchWorkspace: malloc failed to allocate\n\n");
+    exit(-1);
+  }
+
+  for (i = 0; i < size; ++i)  // nothing touched yet:
+    W->Stamp[i] = 0;
+
+  W->Epoch = 0;
+  W->PQ = CreatePQueue(size);
+  W->S = CreateStack(size);
+  W->Capacity = N;
+
+  return W;
+}
+
+//
+// DeleteSearchWorkspace:
+//
+// Frees the memory associated with this workspace.
+//
+void DeleteSearchWorkspace(SearchWorkspace *W)
+{
+  myfree(W->Stamp);
+  myfree(W->Distance);
+  myfree(W->Predecessor);
+  myfree(W->Distance2);
+  myfree(W->Predecessor2);
+  myfree(W->Order);
+  myfree(W->Order2);
+  DeletePQueue(W->PQ);
+  DeleteStack(W->S);
+  myfree(W);
+}
+
+//
+// BeginSearch:
+//
+// Starts a new search:  afterwards, no vertex is touched.  This is
+// O(1), except once every 2^32 searches when the stamps wrap around
+// and must be cleared.
+//
+void BeginSearch(SearchWorkspace *W)
+{
+  W->Epoch++;
+
+  if (W->Epoch == 0)  // wrapped around:
+  {
+    memset(W->Stamp, 0, W->Capacity * sizeof(unsigned int));
+    W->Epoch = 1;
+  }
+}
+
+//
+// StartSearch:
+//
+// Returns the workspace for a search over a graph of N vertices:
+// W if the caller supplied one, or else a temporary workspace that
+// EndSearch will free.  Either way, BeginSearch has been called.
+// Prints an error message and exits the program if W is too small.
+//
+SearchWorkspace *StartSearch(SearchWorkspace *W, int N)
+{
+  if (W == NULL)  // temporary:
+    W = CreateSearchWorkspace(N);
+  else if (W->Capacity < N)
+  {
+    printf("\n**Error in StartSearch: workspace too small (%d < %d)\n\n", W->Capacity, N);
+    exit(-1);
+  }
+
+  BeginSearch(W);
+
+  return W;
+}
+
+//
+// EndSearch:
+//
+// Ends a search started by StartSearch(given, N), which returned
+// W; frees W if it was temporary.
+//
+void EndSearch(SearchWorkspace *W, SearchWorkspace *given)
+{
+  if (W != given)
+    DeleteSearchWorkspace(W);
+}
@@ -0,0 +1,38 @@
+/*workspace.h*/
+
+//
+// Search workspace:
+//
+// Scratch memory for the graph searches (BFS, BFSd, DFS, Dijkstra,
+// AStar, BidirectionalBFS), sized for a graph of up to Capacity
+// vertices.  Allocate one, and pass it to every search; a search
+// then costs time proportional to the vertices it touches, rather
+// than to the size of the graph.
+//
+// The per-vertex arrays are not cleared between searches.  Instead,
+// each search starts by calling BeginSearch, which bumps Epoch; a
+// vertex has been touched by the current search iff its Stamp equals
+// Epoch, and only then are its Distance etc. meaningful.
+//
+// A workspace may be used by only one search at a time.
+//
+typedef struct SearchWorkspace
+{
+  unsigned int  *Stamp;         // Stamp[v] == Epoch => v touched by this search
+  unsigned int   Epoch;
+  int           *Distance;      // valid only for touched vertices:
+  int           *Predecessor;
+  int           *Distance2;     // second side of bidirectional search:
+  int           *Predecessor2;
+  int           *Order;         // vertices in order discovered, Capacity
+  int           *Order2;        // same, second side
+  struct PQueue *PQ;            // empty between searches
+  struct Stack  *S;             // empty between searches
+  int            Capacity;
+} SearchWorkspace;
+
+SearchWorkspace *CreateSearchWorkspace(int N);
+void             DeleteSearchWorkspace(SearchWorkspace *W);
+void             BeginSearch(SearchWorkspace *W);
+SearchWorkspace *StartSearch(SearchWorkspace *W, int N);
+void             EndSearch(SearchWorkspace *W, SearchWorkspace *given);